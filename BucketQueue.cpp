@@ -0,0 +1,413 @@
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <chrono>
+
+#ifndef UNITY_BUILD
+#include "LatencyHistogram.cpp"
+#include "MemoryAllocation.cpp"
+#endif
+
+typedef HeapOperationStats BucketQueueStats;
+
+// Per thread, like the pairing and Fibonacci heap stats.
+static thread_local BucketQueueStats bucketQueueStats;
+
+static void ResetBucketQueueStats()
+{
+    bucketQueueStats = BucketQueueStats();
+}
+
+static BucketQueueStats GetBucketQueueStats()
+{
+    return bucketQueueStats;
+}
+
+class BucketQueueNode
+{
+public:
+    int priorityKey;
+    int vertexId;
+    // Slot in the bucket array, or OVERFLOW_BUCKET while the node waits in the overflow list.
+    int bucketIndex;
+    BucketQueueNode* previous;
+    BucketQueueNode* next;
+
+    BucketQueueNode(int key, int v)
+    {
+        priorityKey = key;
+        vertexId = v;
+        bucketIndex = -1;
+        previous = nullptr;
+        next = nullptr;
+    }
+};
+
+// Dial's bucket queue: a circular array of keySpread + 1 buckets, one per key value, and a
+// cursor that walks it upward. Every bucketed key lies in [cursorKey, cursorKey + keySpread],
+// so each slot holds a single key value and DeleteMin only has to find the next non-empty slot.
+// Keys beyond that window (the INF keys of Dijkstra and Prim, or weights above keySpread) wait
+// in an unordered overflow list and are moved into buckets once the cursor gets near them.
+//
+// Any int keys are accepted and the order is always exact; the queue is fast when the keys in it
+// stay within keySpread of each other. That holds for Dijkstra and for Prim when every edge
+// weight is in [0, keySpread]: Dijkstra keys never exceed the last settled distance plus the
+// largest weight, and Prim keys are edge weights. Each refill scans the whole overflow list, so
+// a keySpread far below the real gaps between keys degrades towards quadratic time.
+class BucketQueue
+{
+private:
+    static const int OVERFLOW_BUCKET = -1;
+
+    std::vector<BucketQueueNode*> buckets;
+    int keySpread;
+    long long cursorKey;
+    int cursorIndex;
+    // Upper bound on the largest bucketed key; only needed when the cursor moves down.
+    long long highestBucketedKey;
+    int bucketedCount;
+    BucketQueueNode* overflowHead;
+    // Lower bound on the smallest overflow key; exact right after RefillFromOverflow.
+    long long overflowMinKey;
+    int nodeCount;
+    HeapNodePool<BucketQueueNode> nodePool;
+
+public:
+    explicit BucketQueue(int maxKeySpread);
+
+    BucketQueueNode* Insert(int key, int vertexId);
+    BucketQueueNode* FindMin();
+    BucketQueueNode* DeleteMin();
+    void DecreaseKey(BucketQueueNode* node, int newKey);
+    int Count();
+
+    // Moving a node between buckets is already O(1) with nothing to combine later, so staging
+    // applies at once, exactly like DecreaseKey; Apply has nothing left to do.
+    void StageDecreaseKey(BucketQueueNode* node, int newKey);
+    void ApplyStagedDecreaseKeys() {}
+
+    void ReleaseNode(BucketQueueNode* node)
+    {
+        nodePool.Release(node);
+    }
+
+    // Drops every queued node without timing or counting anything; handles become invalid.
+    void Clear();
+
+private:
+    void Place(BucketQueueNode* node);
+    void Unlink(BucketQueueNode* node);
+    void PushBucket(BucketQueueNode* node, int index);
+    void PushOverflow(BucketQueueNode* node);
+    void LowerCursor(long long key);
+    void RefillFromOverflow();
+    int SlotFor(long long key) const;
+    BucketQueueNode* AdvanceToMin();
+};
+
+BucketQueue::BucketQueue(int maxKeySpread)
+{
+    if (maxKeySpread < 0)
+    {
+        throw std::runtime_error("BucketQueue key spread must not be negative");
+    }
+
+    keySpread = maxKeySpread;
+    buckets.assign((size_t)keySpread + 1, nullptr);
+    cursorKey = 0;
+    cursorIndex = 0;
+    highestBucketedKey = 0;
+    bucketedCount = 0;
+    overflowHead = nullptr;
+    overflowMinKey = std::numeric_limits<long long>::max();
+    nodeCount = 0;
+}
+
+// Slot of a key inside the current window [cursorKey, cursorKey + keySpread].
+int BucketQueue::SlotFor(long long key) const
+{
+    long long index = cursorIndex + (key - cursorKey);
+    if (index > keySpread)
+    {
+        index -= keySpread + 1;
+    }
+    return (int)index;
+}
+
+void BucketQueue::PushBucket(BucketQueueNode* node, int index)
+{
+    node->bucketIndex = index;
+    node->previous = nullptr;
+    node->next = buckets[index];
+    if (buckets[index] != nullptr)
+    {
+        buckets[index]->previous = node;
+    }
+    buckets[index] = node;
+
+    if (node->priorityKey > highestBucketedKey)
+    {
+        highestBucketedKey = node->priorityKey;
+    }
+    bucketedCount++;
+}
+
+void BucketQueue::PushOverflow(BucketQueueNode* node)
+{
+    node->bucketIndex = OVERFLOW_BUCKET;
+    node->previous = nullptr;
+    node->next = overflowHead;
+    if (overflowHead != nullptr)
+    {
+        overflowHead->previous = node;
+    }
+    overflowHead = node;
+
+    if (node->priorityKey < overflowMinKey)
+    {
+        overflowMinKey = node->priorityKey;
+    }
+}
+
+void BucketQueue::Unlink(BucketQueueNode* node)
+{
+    if (node->previous != nullptr)
+    {
+        node->previous->next = node->next;
+    }
+    else if (node->bucketIndex == OVERFLOW_BUCKET)
+    {
+        overflowHead = node->next;
+    }
+    else
+    {
+        buckets[node->bucketIndex] = node->next;
+    }
+
+    if (node->next != nullptr)
+    {
+        node->next->previous = node->previous;
+    }
+
+    if (node->bucketIndex != OVERFLOW_BUCKET)
+    {
+        bucketedCount--;
+    }
+
+    node->previous = nullptr;
+    node->next = nullptr;
+}
+
+// Moves the window down so that it starts at key. Buckets whose keys no longer fit are moved to
+// the overflow list; with Prim and small weights the window already covers every key and this
+// only moves the cursor.
+void BucketQueue::LowerCursor(long long key)
+{
+    if (highestBucketedKey > key + keySpread)
+    {
+        long long firstEvictedKey = std::max(key + keySpread + 1, cursorKey);
+        for (long long evictedKey = firstEvictedKey; evictedKey <= highestBucketedKey; evictedKey++)
+        {
+            int index = SlotFor(evictedKey);
+            while (buckets[index] != nullptr)
+            {
+                BucketQueueNode* node = buckets[index];
+                Unlink(node);
+                PushOverflow(node);
+            }
+        }
+        highestBucketedKey = key + keySpread;
+    }
+
+    long long width = (long long)keySpread + 1;
+    cursorIndex = (int)((((cursorIndex - (cursorKey - key)) % width) + width) % width);
+    cursorKey = key;
+}
+
+void BucketQueue::Place(BucketQueueNode* node)
+{
+    long long key = node->priorityKey;
+
+    if (bucketedCount == 0)
+    {
+        // No bucketed keys to keep in the window, so it can restart at this key, unless the
+        // overflow list may hold something smaller.
+        if (key > overflowMinKey)
+        {
+            PushOverflow(node);
+            return;
+        }
+        cursorKey = key;
+        highestBucketedKey = key;
+    }
+    else if (key < cursorKey)
+    {
+        LowerCursor(key);
+    }
+    else if (key > cursorKey + keySpread)
+    {
+        PushOverflow(node);
+        return;
+    }
+
+    PushBucket(node, SlotFor(key));
+}
+
+// Pulls every overflow node that fits the window into the buckets, first moving the window to
+// the smallest overflow key if nothing is bucketed or that key lies below the cursor.
+void BucketQueue::RefillFromOverflow()
+{
+    long long smallestKey = std::numeric_limits<long long>::max();
+    for (BucketQueueNode* node = overflowHead; node != nullptr; node = node->next)
+    {
+        if (node->priorityKey < smallestKey)
+        {
+            smallestKey = node->priorityKey;
+        }
+    }
+
+    if (bucketedCount == 0)
+    {
+        cursorKey = smallestKey;
+        highestBucketedKey = smallestKey;
+    }
+    else if (smallestKey < cursorKey)
+    {
+        LowerCursor(smallestKey);
+    }
+
+    long long windowEnd = cursorKey + keySpread;
+    overflowMinKey = std::numeric_limits<long long>::max();
+
+    BucketQueueNode* node = overflowHead;
+    while (node != nullptr)
+    {
+        BucketQueueNode* nextNode = node->next;
+        if (node->priorityKey <= windowEnd)
+        {
+            Unlink(node);
+            PushBucket(node, SlotFor(node->priorityKey));
+        }
+        else if (node->priorityKey < overflowMinKey)
+        {
+            overflowMinKey = node->priorityKey;
+        }
+        node = nextNode;
+    }
+}
+
+// Walks the cursor to the first non-empty bucket. Before each step it checks the overflow
+// bound, so an overflow key never gets passed by the cursor.
+BucketQueueNode* BucketQueue::AdvanceToMin()
+{
+    while (true)
+    {
+        if (overflowHead != nullptr && (bucketedCount == 0 || cursorKey >= overflowMinKey))
+        {
+            RefillFromOverflow();
+        }
+
+        if (buckets[cursorIndex] != nullptr)
+        {
+            return buckets[cursorIndex];
+        }
+
+        cursorKey++;
+        cursorIndex = (cursorIndex == keySpread) ? 0 : cursorIndex + 1;
+    }
+}
+
+BucketQueueNode* BucketQueue::Insert(int key, int vertexId)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    BucketQueueNode* newNode = nodePool.Allocate(key, vertexId);
+    Place(newNode);
+    nodeCount++;
+
+    auto endTime = std::chrono::steady_clock::now();
+    bucketQueueStats.insertLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+
+    return newNode;
+}
+
+BucketQueueNode* BucketQueue::FindMin()
+{
+    if (nodeCount == 0)
+    {
+        throw std::runtime_error("FindMin on empty heap");
+    }
+    return AdvanceToMin();
+}
+
+BucketQueueNode* BucketQueue::DeleteMin()
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (nodeCount == 0)
+    {
+        throw std::runtime_error("DeleteMin on empty heap");
+    }
+
+    BucketQueueNode* minimumNode = AdvanceToMin();
+    Unlink(minimumNode);
+    nodeCount--;
+
+    auto endTime = std::chrono::steady_clock::now();
+    bucketQueueStats.deleteMinLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+
+    return minimumNode;
+}
+
+void BucketQueue::DecreaseKey(BucketQueueNode* node, int newKey)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (newKey >= node->priorityKey)
+    {
+        throw std::runtime_error("New key is not smaller than current key in DecreaseKey");
+    }
+
+    Unlink(node);
+    node->priorityKey = newKey;
+    Place(node);
+
+    auto endTime = std::chrono::steady_clock::now();
+    bucketQueueStats.decreaseKeyLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+}
+
+void BucketQueue::StageDecreaseKey(BucketQueueNode* node, int newKey)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (newKey >= node->priorityKey)
+    {
+        throw std::runtime_error("New key is not smaller than current key in StageDecreaseKey");
+    }
+
+    Unlink(node);
+    node->priorityKey = newKey;
+    Place(node);
+    bucketQueueStats.stagedDecreaseKeys++;
+
+    auto endTime = std::chrono::steady_clock::now();
+    bucketQueueStats.decreaseKeyLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+}
+
+void BucketQueue::Clear()
+{
+    buckets.assign(buckets.size(), nullptr);
+    cursorKey = 0;
+    cursorIndex = 0;
+    highestBucketedKey = 0;
+    bucketedCount = 0;
+    overflowHead = nullptr;
+    overflowMinKey = std::numeric_limits<long long>::max();
+    nodeCount = 0;
+    nodePool.Clear();
+}
+
+int BucketQueue::Count()
+{
+    return nodeCount;
+}
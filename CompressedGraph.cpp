@@ -0,0 +1,228 @@
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#endif
+
+// Compressed adjacency. Each neighbor list is sorted by target and stored as a byte-aligned
+// varint stream. Every edge becomes one varint holding
+//     (gap << weightBits) | (weight - minWeight)
+// where gap is the zigzag-encoded difference to the source vertex for the first edge and the
+// difference to the previous target afterwards. weightBits is just wide enough for the weight
+// range of the whole graph, so small-range weights cost only a few bits inside the varint.
+class CompressedGraph
+{
+public:
+    std::vector<unsigned long long> byteOffsets;
+    std::vector<int> degrees;
+    std::vector<unsigned char> bytes;
+    int minWeight;
+    int maxWeight;
+    int weightBits;
+    int maxDegree;
+    long long directedEdgeCount;
+
+    static CompressedGraph FromGraph(const Graph& graph);
+
+    int Count() const
+    {
+        return (int)degrees.size();
+    }
+
+    int Degree(int u) const
+    {
+        return degrees[u];
+    }
+
+    int MaxDegree() const
+    {
+        return maxDegree;
+    }
+
+    long long DirectedEdgeCount() const
+    {
+        return directedEdgeCount;
+    }
+
+    int MinEdgeWeight() const
+    {
+        return minWeight;
+    }
+
+    int MaxEdgeWeight() const
+    {
+        return maxWeight;
+    }
+
+    long long AdjacencyBytes() const
+    {
+        return (long long)(byteOffsets.size() * sizeof(unsigned long long) + degrees.size() * sizeof(int) + bytes.size());
+    }
+
+    // Decodes the neighbors of u into scratch, which must hold at least Degree(u) edges.
+    const Edge* NeighborEdges(int u, Edge* scratch) const;
+};
+
+static void AppendVarint(std::vector<unsigned char>& bytes, unsigned long long value)
+{
+    while (value >= 0x80)
+    {
+        bytes.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back((unsigned char)value);
+}
+
+static unsigned long long ZigzagEncode(long long value)
+{
+    return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+static long long ZigzagDecode(unsigned long long value)
+{
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+// Streaming decoder over one vertex's compressed neighbor list.
+class CompressedNeighborCursor
+{
+private:
+    const unsigned char* position;
+    int remaining;
+    int previousTarget;
+    bool first;
+    int minWeight;
+    int weightBits;
+    unsigned long long weightMask;
+
+public:
+    CompressedNeighborCursor(const CompressedGraph& graph, int u)
+    {
+        position = graph.bytes.data() + graph.byteOffsets[u];
+        remaining = graph.degrees[u];
+        previousTarget = u;
+        first = true;
+        minWeight = graph.minWeight;
+        weightBits = graph.weightBits;
+        weightMask = (1ULL << weightBits) - 1;
+    }
+
+    bool Next(Edge& edge)
+    {
+        if (remaining == 0)
+        {
+            return false;
+        }
+
+        unsigned long long value = 0;
+        int shift = 0;
+        unsigned char byte;
+        do
+        {
+            byte = *position++;
+            value |= (unsigned long long)(byte & 0x7F) << shift;
+            shift += 7;
+        }
+        while (byte & 0x80);
+
+        unsigned long long gap = value >> weightBits;
+        int target = first ? (int)(previousTarget + ZigzagDecode(gap)) : (int)(previousTarget + (long long)gap);
+
+        edge.to = target;
+        edge.weight = minWeight + (int)(value & weightMask);
+
+        previousTarget = target;
+        first = false;
+        remaining--;
+        return true;
+    }
+};
+
+CompressedGraph CompressedGraph::FromGraph(const Graph& graph)
+{
+    CompressedGraph compressed;
+
+    int numberOfVertices = graph.Count();
+    int lowestWeight = 0;
+    int highestWeight = 0;
+    bool anyEdge = false;
+
+    for (int u = 0; u < numberOfVertices; u++)
+    {
+        for (int edgeIndex = 0; edgeIndex < (int)graph.adj[u].size(); edgeIndex++)
+        {
+            int weight = graph.adj[u][edgeIndex].weight;
+            if (!anyEdge || weight < lowestWeight)
+            {
+                lowestWeight = weight;
+            }
+            if (!anyEdge || weight > highestWeight)
+            {
+                highestWeight = weight;
+            }
+            anyEdge = true;
+        }
+    }
+
+    compressed.minWeight = lowestWeight;
+    compressed.maxWeight = highestWeight;
+    compressed.weightBits = 0;
+    while (((unsigned long long)((long long)highestWeight - lowestWeight) >> compressed.weightBits) != 0)
+    {
+        compressed.weightBits++;
+    }
+    if (compressed.weightBits > 30)
+    {
+        throw std::runtime_error("Weight range too large for CompressedGraph");
+    }
+
+    compressed.byteOffsets.resize(numberOfVertices + 1, 0);
+    compressed.degrees.resize(numberOfVertices, 0);
+    compressed.maxDegree = 0;
+    compressed.directedEdgeCount = graph.DirectedEdgeCount();
+
+    std::vector<Edge> sortedEdges;
+
+    for (int u = 0; u < numberOfVertices; u++)
+    {
+        sortedEdges.assign(graph.adj[u].begin(), graph.adj[u].end());
+        std::sort(sortedEdges.begin(), sortedEdges.end(), [](const Edge& a, const Edge& b) {
+            return a.to < b.to || (a.to == b.to && a.weight < b.weight);
+        });
+
+        compressed.byteOffsets[u] = compressed.bytes.size();
+        compressed.degrees[u] = (int)sortedEdges.size();
+        compressed.maxDegree = std::max(compressed.maxDegree, (int)sortedEdges.size());
+
+        long long previousTarget = u;
+        for (int edgeIndex = 0; edgeIndex < (int)sortedEdges.size(); edgeIndex++)
+        {
+            long long difference = (long long)sortedEdges[edgeIndex].to - previousTarget;
+            unsigned long long gap = (edgeIndex == 0) ? ZigzagEncode(difference) : (unsigned long long)difference;
+            unsigned long long weightCode = (unsigned long long)(sortedEdges[edgeIndex].weight - lowestWeight);
+
+            AppendVarint(compressed.bytes, (gap << compressed.weightBits) | weightCode);
+            previousTarget = sortedEdges[edgeIndex].to;
+        }
+    }
+
+    compressed.byteOffsets[numberOfVertices] = compressed.bytes.size();
+    compressed.bytes.shrink_to_fit();
+
+    return compressed;
+}
+
+const Edge* CompressedGraph::NeighborEdges(int u, Edge* scratch) const
+{
+    CompressedNeighborCursor cursor(*this, u);
+    int decoded = 0;
+
+    while (cursor.Next(scratch[decoded]))
+    {
+        decoded++;
+    }
+
+    return scratch;
+}
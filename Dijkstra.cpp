@@ -6,11 +6,16 @@
 #include "Graph.cpp"
 #include "PairingHeap.cpp"
 #include "FibonacciHeap.cpp"
+#include "BucketQueue.cpp"
+#include "CompressedGraph.cpp"
+#include "Relaxation.cpp"
 #endif
 
-template <typename HeapType, typename HeapNodeType>
+// GraphType is Graph or CompressedGraph: anything with Count, Degree, MaxDegree and
+// NeighborEdges(u, scratch), which returns the neighbors of u as a contiguous Edge array.
+template <typename HeapType, typename HeapNodeType, typename GraphType>
 static std::pair<std::vector<int>, std::vector<int>>
-DijkstraImplementation(const Graph& graph, int sourceVertex)
+DijkstraImplementation(const GraphType& graph, int sourceVertex, HeapType& priorityQueue)
 {
     const int INF = std::numeric_limits<int>::max() / 4;
 
@@ -20,8 +25,11 @@ DijkstraImplementation(const Graph& graph, int sourceVertex)
     std::vector<int> previousVertexOnShortestPath(numberOfVertices, -1);
     std::vector<bool> vertexHasFinalDistance(numberOfVertices, false);
 
-    HeapType priorityQueue;
     std::vector<HeapNodeType*> heapNodeHandleForVertex(numberOfVertices, nullptr);
+    std::vector<int> improvedEdgeIndices(graph.MaxDegree());
+    std::vector<Edge> decodedEdges(graph.MaxDegree(), Edge(0, 0));
+    RelaxationKernel findImprovedEdges = activeRelaxationKernel;
+    bool stageDecreaseKeys = stageRelaxedDecreaseKeys;
 
     for (int currentVertex = 0; currentVertex < numberOfVertices; currentVertex++)
     {
@@ -40,6 +48,7 @@ DijkstraImplementation(const Graph& graph, int sourceVertex)
     {
         HeapNodeType* minimumHeapNode = priorityQueue.DeleteMin();
         int vertexWithSmallestDistance = minimumHeapNode->vertexId;
+        priorityQueue.ReleaseNode(minimumHeapNode);
 
         if (vertexHasFinalDistance[vertexWithSmallestDistance])
         {
@@ -53,40 +62,87 @@ DijkstraImplementation(const Graph& graph, int sourceVertex)
             break;
         }
 
-        for (int outgoingEdgeIndex = 0; outgoingEdgeIndex < (int)graph.adj[vertexWithSmallestDistance].size(); outgoingEdgeIndex++)
-        {
-            const Edge& outgoingEdge = graph.adj[vertexWithSmallestDistance][outgoingEdgeIndex];
-            int neighborVertex = outgoingEdge.to;
+        // Finalized neighbors never show up as improved: their distance is already at most the
+        // distance of the vertex being settled, so the kernel can skip the vertexHasFinalDistance test.
+        const Edge* outgoingEdges = graph.NeighborEdges(vertexWithSmallestDistance, decodedEdges.data());
+        int outgoingEdgeCount = graph.Degree(vertexWithSmallestDistance);
+        int baseDistance = shortestDistanceToVertex[vertexWithSmallestDistance];
+        int improvedEdgeCount = findImprovedEdges(outgoingEdges, outgoingEdgeCount, baseDistance,
+                                                  shortestDistanceToVertex.data(), improvedEdgeIndices.data());
 
-            if (vertexHasFinalDistance[neighborVertex])
+        for (int improvedIndex = 0; improvedIndex < improvedEdgeCount; improvedIndex++)
+        {
+            // Handle and parent entries are fetched a few edges ahead; the heap node a handle points
+            // to is fetched one edge ahead, once the handle itself is likely in cache.
+            if (PQ_PREFETCH_ENABLED && improvedIndex + PQ_PREFETCH_DISTANCE < improvedEdgeCount)
+            {
+                int upcomingVertex = outgoingEdges[improvedEdgeIndices[improvedIndex + PQ_PREFETCH_DISTANCE]].to;
+                PQ_PREFETCH(&heapNodeHandleForVertex[upcomingVertex]);
+                PQ_PREFETCH_WRITE(&previousVertexOnShortestPath[upcomingVertex]);
+            }
+            if (PQ_PREFETCH_ENABLED && improvedIndex + 1 < improvedEdgeCount)
             {
-                continue;
+                PQ_PREFETCH_WRITE(heapNodeHandleForVertex[outgoingEdges[improvedEdgeIndices[improvedIndex + 1]].to]);
             }
 
-            int candidateDistance =
-                shortestDistanceToVertex[vertexWithSmallestDistance] + outgoingEdge.weight;
+            const Edge& outgoingEdge = outgoingEdges[improvedEdgeIndices[improvedIndex]];
+            int neighborVertex = outgoingEdge.to;
+
+            int candidateDistance = baseDistance + outgoingEdge.weight;
 
             if (candidateDistance < shortestDistanceToVertex[neighborVertex])
             {
                 shortestDistanceToVertex[neighborVertex] = candidateDistance;
                 previousVertexOnShortestPath[neighborVertex] = vertexWithSmallestDistance;
 
-                priorityQueue.DecreaseKey(heapNodeHandleForVertex[neighborVertex], candidateDistance);
+                if (stageDecreaseKeys)
+                {
+                    priorityQueue.StageDecreaseKey(heapNodeHandleForVertex[neighborVertex], candidateDistance);
+                }
+                else
+                {
+                    priorityQueue.DecreaseKey(heapNodeHandleForVertex[neighborVertex], candidateDistance);
+                }
             }
         }
+
+        if (stageDecreaseKeys)
+        {
+            priorityQueue.ApplyStagedDecreaseKeys();
+        }
     }
 
+    // Vertices unreachable from the start are still queued when the loop breaks; Clear drops
+    // them without the timed DeleteMin calls a drain would add to the stats.
+    priorityQueue.Clear();
+
     return {shortestDistanceToVertex, previousVertexOnShortestPath};
 }
 
+template <typename GraphType>
+static std::pair<std::vector<int>, std::vector<int>>
+DijkstraUsingPairingHeap(const GraphType& graph, int sourceVertex,
+                         PairingHeapMergeStrategy mergeStrategy = PairingHeapMergeStrategy::TwoPass)
+{
+    PairingHeap priorityQueue(mergeStrategy);
+    return DijkstraImplementation<PairingHeap, PairingHeapNode, GraphType>(graph, sourceVertex, priorityQueue);
+}
+
+template <typename GraphType>
 static std::pair<std::vector<int>, std::vector<int>>
-DijkstraUsingPairingHeap(const Graph& graph, int sourceVertex)
+DijkstraUsingFibonacciHeap(const GraphType& graph, int sourceVertex)
 {
-    return DijkstraImplementation<PairingHeap, PairingHeapNode>(graph, sourceVertex);
+    FibonacciHeap priorityQueue;
+    return DijkstraImplementation<FibonacciHeap, FibonacciHeapNode, GraphType>(graph, sourceVertex, priorityQueue);
 }
 
+// Only pays off when edge weights are small non-negative integers; maxEdgeWeight sets the bucket
+// window. Heavier edges stay correct but go through the queue's overflow list, which gets slow
+// when many weights exceed maxEdgeWeight.
+template <typename GraphType>
 static std::pair<std::vector<int>, std::vector<int>>
-DijkstraUsingFibonacciHeap(const Graph& graph, int sourceVertex)
+DijkstraUsingBucketQueue(const GraphType& graph, int sourceVertex, int maxEdgeWeight)
 {
-    return DijkstraImplementation<FibonacciHeap, FibonacciHeapNode>(graph, sourceVertex);
-}
\ No newline at end of file
+    BucketQueue priorityQueue(maxEdgeWeight);
+    return DijkstraImplementation<BucketQueue, BucketQueueNode, GraphType>(graph, sourceVertex, priorityQueue);
+}
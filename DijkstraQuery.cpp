@@ -0,0 +1,226 @@
+#include <vector>
+#include <limits>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#include "PairingHeap.cpp"
+#include "FibonacciHeap.cpp"
+#include "CompressedGraph.cpp"
+#include "Relaxation.cpp"
+#endif
+
+// Early-termination limits for a single-source query. A vertex is settled only if its
+// distance is at most distanceLimit; the search stops after settledLimit vertices, or as soon
+// as one target is settled (all of them when settleAllTargets is set). Leave a field at its
+// default to disable that limit.
+struct DijkstraQuery
+{
+    int distanceLimit = std::numeric_limits<int>::max() / 4;
+    int settledLimit = std::numeric_limits<int>::max();
+    std::vector<int> targets;
+    bool settleAllTargets = false;
+};
+
+// Only the settled vertices are reported, in the order they were settled, so the size of the
+// result follows the explored region rather than the graph.
+struct DijkstraQueryResult
+{
+    std::vector<int> settledVertices;
+    std::vector<int> settledDistances;
+    std::vector<int> settledPredecessors;
+    int firstTargetReached = -1;
+    int targetsReached = 0;
+};
+
+// Per-vertex arrays reused across queries. Entries are reset through touchedVertices after
+// each query instead of being reallocated, so a query costs O(explored region) after the first.
+// The arrays are sized when the workspace is first used on a graph; that graph must not gain
+// edges while the workspace is bound to it.
+template <typename HeapNodeType>
+struct DijkstraWorkspace
+{
+    std::vector<int> distance;
+    std::vector<int> previous;
+    std::vector<bool> settled;
+    std::vector<bool> isTarget;
+    std::vector<HeapNodeType*> handle;
+    std::vector<int> touchedVertices;
+    std::vector<int> improvedEdgeIndices;
+    std::vector<Edge> decodedEdges;
+    const void* boundGraph = nullptr;
+
+    template <typename GraphType>
+    void Prepare(const GraphType& graph)
+    {
+        const int INF = std::numeric_limits<int>::max() / 4;
+
+        if (boundGraph != &graph || (int)distance.size() != graph.Count())
+        {
+            boundGraph = &graph;
+            distance.assign(graph.Count(), INF);
+            previous.assign(graph.Count(), -1);
+            settled.assign(graph.Count(), false);
+            isTarget.assign(graph.Count(), false);
+            handle.assign(graph.Count(), nullptr);
+            touchedVertices.clear();
+            improvedEdgeIndices.resize(graph.MaxDegree());
+            decodedEdges.resize(graph.MaxDegree(), Edge(0, 0));
+        }
+
+        for (int index = 0; index < (int)touchedVertices.size(); index++)
+        {
+            int v = touchedVertices[index];
+            distance[v] = INF;
+            previous[v] = -1;
+            settled[v] = false;
+            isTarget[v] = false;
+            handle[v] = nullptr;
+        }
+        touchedVertices.clear();
+    }
+};
+
+// Dijkstra that only puts discovered vertices in the heap (Insert on first reach, DecreaseKey
+// afterwards) and stops at the first limit in query that is hit. Popped nodes are released as
+// they leave the heap and whatever is left in the frontier is cleared when the query stops.
+template <typename HeapType, typename HeapNodeType, typename GraphType>
+static DijkstraQueryResult
+DijkstraBoundedImplementation(const GraphType& graph, int sourceVertex, const DijkstraQuery& query,
+                              HeapType& priorityQueue, DijkstraWorkspace<HeapNodeType>& workspace)
+{
+    workspace.Prepare(graph);
+
+    DijkstraQueryResult result;
+    RelaxationKernel findImprovedEdges = activeRelaxationKernel;
+    bool stageDecreaseKeys = stageRelaxedDecreaseKeys;
+
+    for (int targetIndex = 0; targetIndex < (int)query.targets.size(); targetIndex++)
+    {
+        int target = query.targets[targetIndex];
+        if (!workspace.isTarget[target])
+        {
+            workspace.isTarget[target] = true;
+            workspace.touchedVertices.push_back(target);
+        }
+    }
+    int distinctTargets = (int)workspace.touchedVertices.size();
+
+    workspace.distance[sourceVertex] = 0;
+    workspace.touchedVertices.push_back(sourceVertex);
+    workspace.handle[sourceVertex] = priorityQueue.Insert(0, sourceVertex);
+
+    while (priorityQueue.Count() > 0 && query.settledLimit > 0)
+    {
+        HeapNodeType* minimumHeapNode = priorityQueue.DeleteMin();
+        int vertexWithSmallestDistance = minimumHeapNode->vertexId;
+        priorityQueue.ReleaseNode(minimumHeapNode);
+        workspace.handle[vertexWithSmallestDistance] = nullptr;
+
+        int baseDistance = workspace.distance[vertexWithSmallestDistance];
+        if (baseDistance > query.distanceLimit)
+        {
+            break;
+        }
+
+        workspace.settled[vertexWithSmallestDistance] = true;
+        result.settledVertices.push_back(vertexWithSmallestDistance);
+        result.settledDistances.push_back(baseDistance);
+        result.settledPredecessors.push_back(workspace.previous[vertexWithSmallestDistance]);
+
+        if (workspace.isTarget[vertexWithSmallestDistance])
+        {
+            if (result.targetsReached == 0)
+            {
+                result.firstTargetReached = vertexWithSmallestDistance;
+            }
+            result.targetsReached++;
+
+            if (!query.settleAllTargets || result.targetsReached == distinctTargets)
+            {
+                break;
+            }
+        }
+
+        if ((int)result.settledVertices.size() >= query.settledLimit)
+        {
+            break;
+        }
+
+        const Edge* outgoingEdges = graph.NeighborEdges(vertexWithSmallestDistance, workspace.decodedEdges.data());
+        int outgoingEdgeCount = graph.Degree(vertexWithSmallestDistance);
+        int improvedEdgeCount = findImprovedEdges(outgoingEdges, outgoingEdgeCount, baseDistance,
+                                                  workspace.distance.data(), workspace.improvedEdgeIndices.data());
+
+        for (int improvedIndex = 0; improvedIndex < improvedEdgeCount; improvedIndex++)
+        {
+            // Same two-stage prefetch as DijkstraImplementation; a null handle is a harmless hint.
+            if (PQ_PREFETCH_ENABLED && improvedIndex + PQ_PREFETCH_DISTANCE < improvedEdgeCount)
+            {
+                int upcomingVertex = outgoingEdges[workspace.improvedEdgeIndices[improvedIndex + PQ_PREFETCH_DISTANCE]].to;
+                PQ_PREFETCH(&workspace.handle[upcomingVertex]);
+                PQ_PREFETCH_WRITE(&workspace.previous[upcomingVertex]);
+            }
+            if (PQ_PREFETCH_ENABLED && improvedIndex + 1 < improvedEdgeCount)
+            {
+                PQ_PREFETCH_WRITE(workspace.handle[outgoingEdges[workspace.improvedEdgeIndices[improvedIndex + 1]].to]);
+            }
+
+            const Edge& outgoingEdge = outgoingEdges[workspace.improvedEdgeIndices[improvedIndex]];
+            int neighborVertex = outgoingEdge.to;
+
+            int candidateDistance = baseDistance + outgoingEdge.weight;
+
+            if (candidateDistance < workspace.distance[neighborVertex])
+            {
+                if (workspace.handle[neighborVertex] == nullptr)
+                {
+                    workspace.touchedVertices.push_back(neighborVertex);
+                    workspace.distance[neighborVertex] = candidateDistance;
+                    workspace.handle[neighborVertex] = priorityQueue.Insert(candidateDistance, neighborVertex);
+                }
+                else
+                {
+                    workspace.distance[neighborVertex] = candidateDistance;
+                    if (stageDecreaseKeys)
+                    {
+                        priorityQueue.StageDecreaseKey(workspace.handle[neighborVertex], candidateDistance);
+                    }
+                    else
+                    {
+                        priorityQueue.DecreaseKey(workspace.handle[neighborVertex], candidateDistance);
+                    }
+                }
+                workspace.previous[neighborVertex] = vertexWithSmallestDistance;
+            }
+        }
+
+        if (stageDecreaseKeys)
+        {
+            priorityQueue.ApplyStagedDecreaseKeys();
+        }
+    }
+
+    // The frontier handles are reset through touchedVertices by the next Prepare.
+    priorityQueue.Clear();
+
+    return result;
+}
+
+template <typename GraphType>
+static DijkstraQueryResult
+DijkstraQueryUsingPairingHeap(const GraphType& graph, int sourceVertex, const DijkstraQuery& query,
+                              DijkstraWorkspace<PairingHeapNode>& workspace,
+                              PairingHeapMergeStrategy mergeStrategy = PairingHeapMergeStrategy::TwoPass)
+{
+    PairingHeap priorityQueue(mergeStrategy);
+    return DijkstraBoundedImplementation<PairingHeap, PairingHeapNode, GraphType>(graph, sourceVertex, query, priorityQueue, workspace);
+}
+
+template <typename GraphType>
+static DijkstraQueryResult
+DijkstraQueryUsingFibonacciHeap(const GraphType& graph, int sourceVertex, const DijkstraQuery& query,
+                                DijkstraWorkspace<FibonacciHeapNode>& workspace)
+{
+    FibonacciHeap priorityQueue;
+    return DijkstraBoundedImplementation<FibonacciHeap, FibonacciHeapNode, GraphType>(graph, sourceVertex, query, priorityQueue, workspace);
+}
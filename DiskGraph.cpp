@@ -0,0 +1,191 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <chrono>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#endif
+
+struct ExternalIoStats
+{
+    long long bytesRead;
+    long long bytesWritten;
+    long long readCalls;
+    long long writeCalls;
+    long long ioWaitNs;
+};
+
+static ExternalIoStats externalIoStats = {0, 0, 0, 0, 0};
+
+static void ResetExternalIoStats()
+{
+    externalIoStats = {0, 0, 0, 0, 0};
+}
+
+static ExternalIoStats GetExternalIoStats()
+{
+    return externalIoStats;
+}
+
+static void CountedRead(std::istream& in, void* destination, long long byteCount)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    in.read(static_cast<char*>(destination), byteCount);
+    if (!in)
+    {
+        throw std::runtime_error("Short read from external storage");
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    externalIoStats.bytesRead = externalIoStats.bytesRead + byteCount;
+    externalIoStats.readCalls = externalIoStats.readCalls + 1;
+    externalIoStats.ioWaitNs = externalIoStats.ioWaitNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+static void CountedWrite(std::ostream& out, const void* source, long long byteCount)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    out.write(static_cast<const char*>(source), byteCount);
+    if (!out)
+    {
+        throw std::runtime_error("Write to external storage failed");
+    }
+
+    auto endTime = std::chrono::steady_clock::now();
+    externalIoStats.bytesWritten = externalIoStats.bytesWritten + byteCount;
+    externalIoStats.writeCalls = externalIoStats.writeCalls + 1;
+    externalIoStats.ioWaitNs = externalIoStats.ioWaitNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+// On-disk CSR layout, all integers little-endian as written by the host:
+//   char[8]  magic "PQCSR001"
+//   int64    vertex count V
+//   int64    directed edge count E
+//   int64    offsets[V + 1]   (edge index of each vertex's first outgoing edge)
+//   Edge     edges[E]         (int32 to, int32 weight)
+static const char CSR_FILE_MAGIC[8] = {'P', 'Q', 'C', 'S', 'R', '0', '0', '1'};
+
+static void WriteGraphToCsrFile(const Graph& graph, const std::string& path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error("Cannot create CSR file " + path);
+    }
+
+    long long vertexCount = graph.Count();
+    std::vector<long long> offsets(vertexCount + 1, 0);
+    for (int u = 0; u < graph.Count(); u++)
+    {
+        offsets[u + 1] = offsets[u] + (long long)graph.adj[u].size();
+    }
+    long long edgeCount = offsets[vertexCount];
+
+    CountedWrite(out, CSR_FILE_MAGIC, sizeof(CSR_FILE_MAGIC));
+    CountedWrite(out, &vertexCount, sizeof(vertexCount));
+    CountedWrite(out, &edgeCount, sizeof(edgeCount));
+    CountedWrite(out, offsets.data(), (long long)offsets.size() * (long long)sizeof(long long));
+
+    for (int u = 0; u < graph.Count(); u++)
+    {
+        if (!graph.adj[u].empty())
+        {
+            CountedWrite(out, graph.adj[u].data(), (long long)graph.adj[u].size() * (long long)sizeof(Edge));
+        }
+    }
+}
+
+// Read-only view of a CSR file. Only the V + 1 offsets are held in memory; adjacency lists
+// are read from disk on demand, one vertex at a time.
+class DiskGraph
+{
+private:
+    std::ifstream in;
+    std::vector<long long> offsets;
+    long long edgeSectionStart;
+    int vertexCount;
+    long long edgeCount;
+
+public:
+    explicit DiskGraph(const std::string& path);
+
+    int Count() const
+    {
+        return vertexCount;
+    }
+
+    long long DirectedEdgeCount() const
+    {
+        return edgeCount;
+    }
+
+    int Degree(int u) const
+    {
+        return (int)(offsets[u + 1] - offsets[u]);
+    }
+
+    // Replaces the contents of neighbors with the outgoing edges of u.
+    void ReadNeighbors(int u, std::vector<Edge>& neighbors);
+};
+
+DiskGraph::DiskGraph(const std::string& path)
+{
+    in.open(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("Cannot open CSR file " + path);
+    }
+
+    char magic[8];
+    long long storedVertexCount = 0;
+    CountedRead(in, magic, sizeof(magic));
+    if (std::memcmp(magic, CSR_FILE_MAGIC, sizeof(magic)) != 0)
+    {
+        throw std::runtime_error("Not a CSR file: " + path);
+    }
+
+    CountedRead(in, &storedVertexCount, sizeof(storedVertexCount));
+    CountedRead(in, &edgeCount, sizeof(edgeCount));
+    vertexCount = (int)storedVertexCount;
+
+    offsets.resize(vertexCount + 1);
+    CountedRead(in, offsets.data(), (long long)offsets.size() * (long long)sizeof(long long));
+
+    edgeSectionStart = (long long)sizeof(CSR_FILE_MAGIC) + 2 * (long long)sizeof(long long) +
+                       (long long)offsets.size() * (long long)sizeof(long long);
+}
+
+void DiskGraph::ReadNeighbors(int u, std::vector<Edge>& neighbors)
+{
+    int degree = Degree(u);
+    neighbors.assign(degree, Edge(0, 0));
+
+    if (degree == 0)
+    {
+        return;
+    }
+
+    in.seekg(edgeSectionStart + offsets[u] * (long long)sizeof(Edge));
+    CountedRead(in, neighbors.data(), (long long)degree * (long long)sizeof(Edge));
+}
+
+// Loads a whole CSR file into an in-memory Graph, for modes that load a graph once and then
+// query it many times.
+static Graph ReadGraphFromCsrFile(const std::string& path)
+{
+    DiskGraph diskGraph(path);
+    Graph graph(diskGraph.Count());
+
+    for (int u = 0; u < diskGraph.Count(); u++)
+    {
+        diskGraph.ReadNeighbors(u, graph.adj[u]);
+    }
+    graph.RecomputeEdgeStatistics();
+
+    return graph;
+}
@@ -0,0 +1,376 @@
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#endif
+
+// Minimum spanning forest maintained under edge insertions and weight decreases. The forest is
+// stored in a link-cut tree in which every forest edge is a node of its own, linked between its
+// two endpoints, so a path aggregate over the tree gives the heaviest edge between two vertices.
+//
+// By the cycle property a new (or cheaper) edge u-v enters the forest exactly when u and v are
+// in different trees, or when it is lighter than the heaviest forest edge on the u-v path, which
+// it then replaces. Each update is a constant number of link-cut operations, O(log V) amortized.
+// Non-forest edges are only remembered so their weight can be lowered later; they never re-enter
+// the forest otherwise, since weights only go down.
+class DynamicMinimumSpanningTree
+{
+private:
+    struct LinkCutNode
+    {
+        int child[2];
+        int parent;
+        bool reversed;
+        int weight;
+        int maxNode;
+    };
+
+    struct TreeEdge
+    {
+        int u;
+        int v;
+        int weight;
+        bool inForest;
+    };
+
+    std::vector<LinkCutNode> nodes;
+    std::vector<TreeEdge> edges;
+    int numberOfVertices;
+    long long totalWeight;
+    int forestEdgeCount;
+    std::vector<int> splayAncestors;
+
+    bool IsSplayRoot(int x) const;
+    void Pull(int x);
+    void Push(int x);
+    void Rotate(int x);
+    void Splay(int x);
+    void Access(int x);
+    void MakeRoot(int x);
+    int FindRoot(int x);
+    void Link(int child, int parent);
+    void Cut(int x, int y);
+    int HeaviestNodeOnPath(int u, int v);
+
+    void LinkEdge(int edgeId);
+    void CutEdge(int edgeId);
+    void OfferEdge(int edgeId);
+
+public:
+    explicit DynamicMinimumSpanningTree(int numberOfVertices);
+
+    // Inserts every undirected edge of graph once.
+    static DynamicMinimumSpanningTree FromGraph(const Graph& graph);
+
+    // Adds the undirected edge u-v and returns its id for later weight decreases.
+    int InsertEdge(int u, int v, int weight);
+
+    // Lowers the weight of edge edgeId. Throws if newWeight is above the current weight.
+    void DecreaseEdgeWeight(int edgeId, int newWeight);
+
+    bool Connected(int u, int v);
+
+    int EdgeWeight(int edgeId) const
+    {
+        return edges[edgeId].weight;
+    }
+
+    bool EdgeInForest(int edgeId) const
+    {
+        return edges[edgeId].inForest;
+    }
+
+    int EdgeCount() const
+    {
+        return (int)edges.size();
+    }
+
+    long long TotalWeight() const
+    {
+        return totalWeight;
+    }
+
+    // V - 1 when the graph is connected.
+    int ForestEdgeCount() const
+    {
+        return forestEdgeCount;
+    }
+};
+
+DynamicMinimumSpanningTree::DynamicMinimumSpanningTree(int numberOfVertices)
+{
+    this->numberOfVertices = numberOfVertices;
+    totalWeight = 0;
+    forestEdgeCount = 0;
+
+    // Vertex nodes weigh less than any edge, so the path maximum is always an edge node.
+    nodes.resize(numberOfVertices);
+    for (int x = 0; x < numberOfVertices; x++)
+    {
+        nodes[x] = {{-1, -1}, -1, false, std::numeric_limits<int>::min(), x};
+    }
+}
+
+DynamicMinimumSpanningTree DynamicMinimumSpanningTree::FromGraph(const Graph& graph)
+{
+    DynamicMinimumSpanningTree tree(graph.Count());
+
+    for (int u = 0; u < graph.Count(); u++)
+    {
+        for (int edgeIndex = 0; edgeIndex < (int)graph.adj[u].size(); edgeIndex++)
+        {
+            const Edge& edge = graph.adj[u][edgeIndex];
+            if (edge.to > u)
+            {
+                tree.InsertEdge(u, edge.to, edge.weight);
+            }
+        }
+    }
+
+    return tree;
+}
+
+bool DynamicMinimumSpanningTree::IsSplayRoot(int x) const
+{
+    int p = nodes[x].parent;
+    return p == -1 || (nodes[p].child[0] != x && nodes[p].child[1] != x);
+}
+
+void DynamicMinimumSpanningTree::Pull(int x)
+{
+    int best = x;
+    for (int side = 0; side < 2; side++)
+    {
+        int c = nodes[x].child[side];
+        if (c != -1 && nodes[nodes[c].maxNode].weight > nodes[best].weight)
+        {
+            best = nodes[c].maxNode;
+        }
+    }
+    nodes[x].maxNode = best;
+}
+
+void DynamicMinimumSpanningTree::Push(int x)
+{
+    if (!nodes[x].reversed)
+    {
+        return;
+    }
+
+    std::swap(nodes[x].child[0], nodes[x].child[1]);
+    for (int side = 0; side < 2; side++)
+    {
+        int c = nodes[x].child[side];
+        if (c != -1)
+        {
+            nodes[c].reversed = !nodes[c].reversed;
+        }
+    }
+    nodes[x].reversed = false;
+}
+
+void DynamicMinimumSpanningTree::Rotate(int x)
+{
+    int p = nodes[x].parent;
+    int g = nodes[p].parent;
+    int side = (nodes[p].child[1] == x) ? 1 : 0;
+    int movedChild = nodes[x].child[1 - side];
+
+    if (!IsSplayRoot(p))
+    {
+        nodes[g].child[(nodes[g].child[1] == p) ? 1 : 0] = x;
+    }
+    nodes[x].parent = g;
+
+    nodes[x].child[1 - side] = p;
+    nodes[p].parent = x;
+
+    nodes[p].child[side] = movedChild;
+    if (movedChild != -1)
+    {
+        nodes[movedChild].parent = p;
+    }
+
+    Pull(p);
+    Pull(x);
+}
+
+void DynamicMinimumSpanningTree::Splay(int x)
+{
+    // Pending reversals have to be pushed top-down before rotating.
+    std::vector<int>& ancestors = splayAncestors;
+    ancestors.clear();
+
+    int y = x;
+    ancestors.push_back(y);
+    while (!IsSplayRoot(y))
+    {
+        y = nodes[y].parent;
+        ancestors.push_back(y);
+    }
+    for (int index = (int)ancestors.size() - 1; index >= 0; index--)
+    {
+        Push(ancestors[index]);
+    }
+
+    while (!IsSplayRoot(x))
+    {
+        int p = nodes[x].parent;
+        if (!IsSplayRoot(p))
+        {
+            int g = nodes[p].parent;
+            bool zigZig = (nodes[g].child[1] == p) == (nodes[p].child[1] == x);
+            Rotate(zigZig ? p : x);
+        }
+        Rotate(x);
+    }
+}
+
+void DynamicMinimumSpanningTree::Access(int x)
+{
+    int last = -1;
+    for (int y = x; y != -1; y = nodes[y].parent)
+    {
+        Splay(y);
+        nodes[y].child[1] = last;
+        Pull(y);
+        last = y;
+    }
+    Splay(x);
+}
+
+void DynamicMinimumSpanningTree::MakeRoot(int x)
+{
+    Access(x);
+    nodes[x].reversed = !nodes[x].reversed;
+}
+
+int DynamicMinimumSpanningTree::FindRoot(int x)
+{
+    Access(x);
+    Push(x);
+    while (nodes[x].child[0] != -1)
+    {
+        x = nodes[x].child[0];
+        Push(x);
+    }
+    Splay(x);
+    return x;
+}
+
+void DynamicMinimumSpanningTree::Link(int child, int parent)
+{
+    MakeRoot(child);
+    nodes[child].parent = parent;
+}
+
+// x and y must be adjacent in the represented tree.
+void DynamicMinimumSpanningTree::Cut(int x, int y)
+{
+    MakeRoot(x);
+    Access(y);
+    nodes[y].child[0] = -1;
+    nodes[x].parent = -1;
+    Pull(y);
+}
+
+int DynamicMinimumSpanningTree::HeaviestNodeOnPath(int u, int v)
+{
+    MakeRoot(u);
+    Access(v);
+    return nodes[v].maxNode;
+}
+
+void DynamicMinimumSpanningTree::LinkEdge(int edgeId)
+{
+    int edgeNode = numberOfVertices + edgeId;
+    Link(edgeNode, edges[edgeId].u);
+    Link(edges[edgeId].v, edgeNode);
+
+    edges[edgeId].inForest = true;
+    totalWeight += edges[edgeId].weight;
+    forestEdgeCount++;
+}
+
+void DynamicMinimumSpanningTree::CutEdge(int edgeId)
+{
+    int edgeNode = numberOfVertices + edgeId;
+    Cut(edgeNode, edges[edgeId].u);
+    Cut(edgeNode, edges[edgeId].v);
+
+    edges[edgeId].inForest = false;
+    totalWeight -= edges[edgeId].weight;
+    forestEdgeCount--;
+}
+
+// Puts a non-forest edge into the forest if the cycle property allows it.
+void DynamicMinimumSpanningTree::OfferEdge(int edgeId)
+{
+    int u = edges[edgeId].u;
+    int v = edges[edgeId].v;
+
+    if (u == v)
+    {
+        return;
+    }
+
+    if (FindRoot(u) != FindRoot(v))
+    {
+        LinkEdge(edgeId);
+        return;
+    }
+
+    int heaviestNode = HeaviestNodeOnPath(u, v);
+    if (nodes[heaviestNode].weight > edges[edgeId].weight)
+    {
+        CutEdge(heaviestNode - numberOfVertices);
+        LinkEdge(edgeId);
+    }
+}
+
+int DynamicMinimumSpanningTree::InsertEdge(int u, int v, int weight)
+{
+    int edgeId = (int)edges.size();
+    int edgeNode = numberOfVertices + edgeId;
+
+    edges.push_back({u, v, weight, false});
+    nodes.push_back({{-1, -1}, -1, false, weight, edgeNode});
+
+    OfferEdge(edgeId);
+    return edgeId;
+}
+
+void DynamicMinimumSpanningTree::DecreaseEdgeWeight(int edgeId, int newWeight)
+{
+    int oldWeight = edges[edgeId].weight;
+    if (newWeight > oldWeight)
+    {
+        throw std::runtime_error("DecreaseEdgeWeight cannot raise a weight");
+    }
+
+    int edgeNode = numberOfVertices + edgeId;
+    edges[edgeId].weight = newWeight;
+
+    if (edges[edgeId].inForest)
+    {
+        // A cheaper forest edge keeps the forest minimal; only the aggregates change. After
+        // Access the node is the root of its splay tree, so nothing above it caches its weight.
+        Access(edgeNode);
+        nodes[edgeNode].weight = newWeight;
+        Pull(edgeNode);
+        totalWeight -= oldWeight - newWeight;
+        return;
+    }
+
+    nodes[edgeNode].weight = newWeight;
+    Pull(edgeNode);
+    OfferEdge(edgeId);
+}
+
+bool DynamicMinimumSpanningTree::Connected(int u, int v)
+{
+    return u == v || FindRoot(u) == FindRoot(v);
+}
@@ -0,0 +1,346 @@
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#include "PairingHeap.cpp"
+#endif
+
+enum class EdgeUpdateKind
+{
+    Insert,
+    Delete,
+    ChangeWeight
+};
+
+// An update to the directed edge from -> to. Delete and ChangeWeight act on the first such
+// edge in the adjacency list; weight is ignored for Delete.
+struct EdgeUpdate
+{
+    EdgeUpdateKind kind;
+    int from;
+    int to;
+    int weight;
+};
+
+// Single-source shortest-path tree kept up to date under edge updates, in the style of
+// Ramalingam-Reps / DynamicSWSF-FP. A batch first applies all of its edge changes. Lengthened
+// edges (delete, weight increase) matter only if they were tree edges; the subtree below each
+// one is invalidated and every vertex in it restarts from its best incoming edge from outside.
+// Shortened edges (insert, weight decrease) seed their head if it improves. One Dijkstra pass
+// over a pairing heap, using DecreaseKey, then settles the changes. Only the vertices whose
+// distance changes and their edges are touched.
+class DynamicShortestPathTree
+{
+private:
+    Graph graph;
+    Graph reverseGraph;
+    int sourceVertex;
+    std::vector<int> shortestDistanceToVertex;
+    std::vector<int> previousVertexOnShortestPath;
+    std::vector<PairingHeapNode*> heapNodeHandleForVertex;
+    std::vector<bool> vertexIsAffected;
+    std::vector<int> affectedVertices;
+    long long touchedVertexCount;
+
+    void LowerDistance(PairingHeap& priorityQueue, int v, int newDistance, int predecessor);
+    void PropagateDecrease(PairingHeap& priorityQueue);
+    void Repair(const std::vector<std::pair<int, int>>& lengthenedEdges,
+                const std::vector<std::pair<int, int>>& shortenedEdges);
+
+public:
+    static constexpr int INF = std::numeric_limits<int>::max() / 4;
+
+    DynamicShortestPathTree(const Graph& initialGraph, int sourceVertex);
+
+    // Index of the first edge to 'to' in edges, or -1. This is the edge Delete and
+    // ChangeWeight updates act on.
+    static int FindEdge(const std::vector<Edge>& edges, int to);
+
+    void InsertEdge(int u, int v, int weight);
+    void DeleteEdge(int u, int v);
+    void ChangeEdgeWeight(int u, int v, int newWeight);
+    void ApplyBatch(const std::vector<EdgeUpdate>& updates);
+
+    const std::vector<int>& Distances() const
+    {
+        return shortestDistanceToVertex;
+    }
+
+    const std::vector<int>& Predecessors() const
+    {
+        return previousVertexOnShortestPath;
+    }
+
+    const Graph& CurrentGraph() const
+    {
+        return graph;
+    }
+
+    // Number of vertices whose distance was recomputed since construction.
+    long long TouchedVertexCount() const
+    {
+        return touchedVertexCount;
+    }
+};
+
+DynamicShortestPathTree::DynamicShortestPathTree(const Graph& initialGraph, int sourceVertex)
+    : graph(initialGraph), reverseGraph(initialGraph.Count())
+{
+    this->sourceVertex = sourceVertex;
+    touchedVertexCount = 0;
+
+    int numberOfVertices = graph.Count();
+    for (int u = 0; u < numberOfVertices; u++)
+    {
+        for (int edgeIndex = 0; edgeIndex < (int)graph.adj[u].size(); edgeIndex++)
+        {
+            reverseGraph.AddEdge(graph.adj[u][edgeIndex].to, u, graph.adj[u][edgeIndex].weight);
+        }
+    }
+
+    shortestDistanceToVertex.assign(numberOfVertices, INF);
+    previousVertexOnShortestPath.assign(numberOfVertices, -1);
+    heapNodeHandleForVertex.assign(numberOfVertices, nullptr);
+    vertexIsAffected.assign(numberOfVertices, false);
+
+    PairingHeap priorityQueue;
+    LowerDistance(priorityQueue, sourceVertex, 0, -1);
+    PropagateDecrease(priorityQueue);
+    touchedVertexCount = 0;
+}
+
+int DynamicShortestPathTree::FindEdge(const std::vector<Edge>& edges, int to)
+{
+    for (int edgeIndex = 0; edgeIndex < (int)edges.size(); edgeIndex++)
+    {
+        if (edges[edgeIndex].to == to)
+        {
+            return edgeIndex;
+        }
+    }
+    return -1;
+}
+
+void DynamicShortestPathTree::InsertEdge(int u, int v, int weight)
+{
+    ApplyBatch({{EdgeUpdateKind::Insert, u, v, weight}});
+}
+
+void DynamicShortestPathTree::DeleteEdge(int u, int v)
+{
+    ApplyBatch({{EdgeUpdateKind::Delete, u, v, 0}});
+}
+
+void DynamicShortestPathTree::ChangeEdgeWeight(int u, int v, int newWeight)
+{
+    ApplyBatch({{EdgeUpdateKind::ChangeWeight, u, v, newWeight}});
+}
+
+void DynamicShortestPathTree::ApplyBatch(const std::vector<EdgeUpdate>& updates)
+{
+    std::vector<std::pair<int, int>> lengthenedEdges;
+    std::vector<std::pair<int, int>> shortenedEdges;
+
+    for (int updateIndex = 0; updateIndex < (int)updates.size(); updateIndex++)
+    {
+        const EdgeUpdate& update = updates[updateIndex];
+        int u = update.from;
+        int v = update.to;
+
+        if (update.kind == EdgeUpdateKind::Insert)
+        {
+            graph.AddEdge(u, v, update.weight);
+            reverseGraph.AddEdge(v, u, update.weight);
+            shortenedEdges.push_back({u, v});
+            continue;
+        }
+
+        int forwardIndex = FindEdge(graph.adj[u], v);
+        if (forwardIndex < 0)
+        {
+            throw std::runtime_error("Edge update on missing edge");
+        }
+        int oldWeight = graph.adj[u][forwardIndex].weight;
+
+        const std::vector<Edge>& incoming = reverseGraph.adj[v];
+        int reverseIndex = 0;
+        while (incoming[reverseIndex].to != u || incoming[reverseIndex].weight != oldWeight)
+        {
+            reverseIndex++;
+        }
+
+        if (update.kind == EdgeUpdateKind::Delete)
+        {
+            graph.RemoveEdge(u, forwardIndex);
+            reverseGraph.RemoveEdge(v, reverseIndex);
+            lengthenedEdges.push_back({u, v});
+        }
+        else
+        {
+            graph.SetEdgeWeight(u, forwardIndex, update.weight);
+            reverseGraph.SetEdgeWeight(v, reverseIndex, update.weight);
+
+            if (update.weight < oldWeight)
+            {
+                shortenedEdges.push_back({u, v});
+            }
+            else if (update.weight > oldWeight)
+            {
+                lengthenedEdges.push_back({u, v});
+            }
+        }
+    }
+
+    Repair(lengthenedEdges, shortenedEdges);
+}
+
+void DynamicShortestPathTree::LowerDistance(PairingHeap& priorityQueue, int v, int newDistance, int predecessor)
+{
+    shortestDistanceToVertex[v] = newDistance;
+    previousVertexOnShortestPath[v] = predecessor;
+
+    if (heapNodeHandleForVertex[v] == nullptr)
+    {
+        heapNodeHandleForVertex[v] = priorityQueue.Insert(newDistance, v);
+        touchedVertexCount++;
+    }
+    else
+    {
+        priorityQueue.DecreaseKey(heapNodeHandleForVertex[v], newDistance);
+    }
+}
+
+void DynamicShortestPathTree::PropagateDecrease(PairingHeap& priorityQueue)
+{
+    while (priorityQueue.Count() > 0)
+    {
+        PairingHeapNode* minimumHeapNode = priorityQueue.DeleteMin();
+        int u = minimumHeapNode->vertexId;
+        priorityQueue.ReleaseNode(minimumHeapNode);
+        heapNodeHandleForVertex[u] = nullptr;
+
+        int baseDistance = shortestDistanceToVertex[u];
+
+        for (int edgeIndex = 0; edgeIndex < (int)graph.adj[u].size(); edgeIndex++)
+        {
+            const Edge& outgoingEdge = graph.adj[u][edgeIndex];
+            int candidateDistance = baseDistance + outgoingEdge.weight;
+
+            if (candidateDistance < shortestDistanceToVertex[outgoingEdge.to])
+            {
+                LowerDistance(priorityQueue, outgoingEdge.to, candidateDistance, u);
+            }
+        }
+    }
+}
+
+// Repairs the tree after a batch of graph changes has been applied. Distances outside the
+// invalidated subtrees are still lengths of real paths, so they are valid upper bounds; the
+// subtrees restart from their best incoming edge, shortened edges seed their endpoints, and one
+// Dijkstra pass over the heap settles everything that can still improve.
+void DynamicShortestPathTree::Repair(const std::vector<std::pair<int, int>>& lengthenedEdges,
+                                     const std::vector<std::pair<int, int>>& shortenedEdges)
+{
+    // A lengthened edge only matters if it was a tree edge. Collect the subtree hanging below
+    // its head; tree children of x are the out-neighbors whose predecessor is x.
+    affectedVertices.clear();
+
+    for (int edgeIndex = 0; edgeIndex < (int)lengthenedEdges.size(); edgeIndex++)
+    {
+        int u = lengthenedEdges[edgeIndex].first;
+        int v = lengthenedEdges[edgeIndex].second;
+
+        if (vertexIsAffected[v] || previousVertexOnShortestPath[v] != u)
+        {
+            continue;
+        }
+
+        int head = (int)affectedVertices.size();
+        affectedVertices.push_back(v);
+        vertexIsAffected[v] = true;
+
+        for (; head < (int)affectedVertices.size(); head++)
+        {
+            int x = affectedVertices[head];
+            for (int outgoingIndex = 0; outgoingIndex < (int)graph.adj[x].size(); outgoingIndex++)
+            {
+                int y = graph.adj[x][outgoingIndex].to;
+                if (!vertexIsAffected[y] && previousVertexOnShortestPath[y] == x)
+                {
+                    vertexIsAffected[y] = true;
+                    affectedVertices.push_back(y);
+                }
+            }
+        }
+    }
+
+    for (int index = 0; index < (int)affectedVertices.size(); index++)
+    {
+        shortestDistanceToVertex[affectedVertices[index]] = INF;
+        previousVertexOnShortestPath[affectedVertices[index]] = -1;
+    }
+
+    PairingHeap priorityQueue;
+
+    for (int index = 0; index < (int)affectedVertices.size(); index++)
+    {
+        int a = affectedVertices[index];
+        int bestDistance = INF;
+        int bestPredecessor = -1;
+
+        for (int incomingIndex = 0; incomingIndex < (int)reverseGraph.adj[a].size(); incomingIndex++)
+        {
+            int p = reverseGraph.adj[a][incomingIndex].to;
+            if (vertexIsAffected[p] || shortestDistanceToVertex[p] == INF)
+            {
+                continue;
+            }
+
+            int candidateDistance = shortestDistanceToVertex[p] + reverseGraph.adj[a][incomingIndex].weight;
+            if (candidateDistance < bestDistance)
+            {
+                bestDistance = candidateDistance;
+                bestPredecessor = p;
+            }
+        }
+
+        if (bestPredecessor >= 0)
+        {
+            LowerDistance(priorityQueue, a, bestDistance, bestPredecessor);
+        }
+    }
+
+    // Shortened edges are re-read from the graph, since a later update in the batch may have
+    // changed or removed them again.
+    for (int edgeIndex = 0; edgeIndex < (int)shortenedEdges.size(); edgeIndex++)
+    {
+        int u = shortenedEdges[edgeIndex].first;
+        int v = shortenedEdges[edgeIndex].second;
+
+        if (vertexIsAffected[u] || shortestDistanceToVertex[u] == INF)
+        {
+            continue;
+        }
+
+        for (int outgoingIndex = 0; outgoingIndex < (int)graph.adj[u].size(); outgoingIndex++)
+        {
+            const Edge& outgoingEdge = graph.adj[u][outgoingIndex];
+            int candidateDistance = shortestDistanceToVertex[u] + outgoingEdge.weight;
+
+            if (outgoingEdge.to == v && candidateDistance < shortestDistanceToVertex[v])
+            {
+                LowerDistance(priorityQueue, v, candidateDistance, u);
+            }
+        }
+    }
+
+    for (int index = 0; index < (int)affectedVertices.size(); index++)
+    {
+        vertexIsAffected[affectedVertices[index]] = false;
+    }
+
+    PropagateDecrease(priorityQueue);
+}
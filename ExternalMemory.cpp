@@ -0,0 +1,145 @@
+#include <vector>
+#include <utility>
+#include <limits>
+#include <string>
+
+#ifndef UNITY_BUILD
+#include "DiskGraph.cpp"
+#include "ExternalPriorityQueue.cpp"
+#endif
+
+// Memory budget for the out-of-core algorithms. Adjacency lives on disk in a DiskGraph and the
+// queue keeps at most queueMemoryEntries entries in RAM plus one block per open run. The
+// per-vertex result arrays (distance/key, parent, settled flag) stay in memory: at 9 bytes per
+// vertex they are small next to the adjacency, which is what outgrows RAM.
+struct ExternalMemoryOptions
+{
+    std::string spillPathPrefix;
+    int queueMemoryEntries;
+    int queueBlockEntries;
+    int queueMergeFanIn;
+};
+
+static ExternalMemoryOptions DefaultExternalMemoryOptions(const std::string& spillPathPrefix)
+{
+    ExternalMemoryOptions options;
+    options.spillPathPrefix = spillPathPrefix;
+    options.queueMemoryEntries = 1 << 20;
+    options.queueBlockEntries = 1 << 12;
+    options.queueMergeFanIn = 8;
+    return options;
+}
+
+static std::pair<std::vector<int>, std::vector<int>>
+DijkstraExternalMemory(DiskGraph& graph, int sourceVertex, const ExternalMemoryOptions& options)
+{
+    const int INF = std::numeric_limits<int>::max() / 4;
+
+    int numberOfVertices = graph.Count();
+
+    std::vector<int> shortestDistanceToVertex(numberOfVertices, INF);
+    std::vector<int> previousVertexOnShortestPath(numberOfVertices, -1);
+    std::vector<bool> vertexHasFinalDistance(numberOfVertices, false);
+
+    ExternalPriorityQueue priorityQueue(options.spillPathPrefix, options.queueMemoryEntries,
+                                        options.queueBlockEntries, options.queueMergeFanIn);
+    std::vector<Edge> outgoingEdges;
+
+    shortestDistanceToVertex[sourceVertex] = 0;
+    priorityQueue.Insert({0, sourceVertex, -1});
+
+    while (priorityQueue.Count() > 0)
+    {
+        ExternalQueueEntry minimumEntry = priorityQueue.DeleteMin();
+        int vertexWithSmallestDistance = minimumEntry.vertexId;
+
+        if (vertexHasFinalDistance[vertexWithSmallestDistance] ||
+            minimumEntry.priorityKey > shortestDistanceToVertex[vertexWithSmallestDistance])
+        {
+            continue;
+        }
+
+        vertexHasFinalDistance[vertexWithSmallestDistance] = true;
+
+        graph.ReadNeighbors(vertexWithSmallestDistance, outgoingEdges);
+
+        for (int outgoingEdgeIndex = 0; outgoingEdgeIndex < (int)outgoingEdges.size(); outgoingEdgeIndex++)
+        {
+            const Edge& outgoingEdge = outgoingEdges[outgoingEdgeIndex];
+            int neighborVertex = outgoingEdge.to;
+
+            int candidateDistance = minimumEntry.priorityKey + outgoingEdge.weight;
+
+            if (candidateDistance < shortestDistanceToVertex[neighborVertex])
+            {
+                shortestDistanceToVertex[neighborVertex] = candidateDistance;
+                previousVertexOnShortestPath[neighborVertex] = vertexWithSmallestDistance;
+
+                priorityQueue.Insert({candidateDistance, neighborVertex, vertexWithSmallestDistance});
+            }
+        }
+    }
+
+    return {shortestDistanceToVertex, previousVertexOnShortestPath};
+}
+
+static std::pair<std::vector<int>, int>
+PrimExternalMemory(DiskGraph& graph, int startVertex, const ExternalMemoryOptions& options)
+{
+    const int INF = std::numeric_limits<int>::max() / 4;
+
+    int numberOfVertices = graph.Count();
+
+    std::vector<int> bestEdgeWeightToReachVertex(numberOfVertices, INF);
+    std::vector<int> parentVertexInMST(numberOfVertices, -1);
+    std::vector<bool> vertexIsAlreadyInMST(numberOfVertices, false);
+
+    ExternalPriorityQueue priorityQueue(options.spillPathPrefix, options.queueMemoryEntries,
+                                        options.queueBlockEntries, options.queueMergeFanIn);
+    std::vector<Edge> outgoingEdges;
+
+    bestEdgeWeightToReachVertex[startVertex] = 0;
+    priorityQueue.Insert({0, startVertex, -1});
+
+    int totalMSTWeight = 0;
+
+    while (priorityQueue.Count() > 0)
+    {
+        ExternalQueueEntry minimumEntry = priorityQueue.DeleteMin();
+        int vertexWithSmallestKey = minimumEntry.vertexId;
+
+        if (vertexIsAlreadyInMST[vertexWithSmallestKey] ||
+            minimumEntry.priorityKey > bestEdgeWeightToReachVertex[vertexWithSmallestKey])
+        {
+            continue;
+        }
+
+        vertexIsAlreadyInMST[vertexWithSmallestKey] = true;
+        parentVertexInMST[vertexWithSmallestKey] = minimumEntry.fromVertex;
+        totalMSTWeight += minimumEntry.priorityKey;
+
+        graph.ReadNeighbors(vertexWithSmallestKey, outgoingEdges);
+
+        for (int outgoingEdgeIndex = 0; outgoingEdgeIndex < (int)outgoingEdges.size(); outgoingEdgeIndex++)
+        {
+            const Edge& outgoingEdge = outgoingEdges[outgoingEdgeIndex];
+            int neighborVertex = outgoingEdge.to;
+
+            if (vertexIsAlreadyInMST[neighborVertex])
+            {
+                continue;
+            }
+
+            int weight = outgoingEdge.weight;
+
+            if (weight < bestEdgeWeightToReachVertex[neighborVertex])
+            {
+                bestEdgeWeightToReachVertex[neighborVertex] = weight;
+
+                priorityQueue.Insert({weight, neighborVertex, vertexWithSmallestKey});
+            }
+        }
+    }
+
+    return {parentVertexInMST, totalMSTWeight};
+}
@@ -0,0 +1,321 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+#ifndef UNITY_BUILD
+#include "DiskGraph.cpp"
+#endif
+
+struct ExternalQueueEntry
+{
+    int priorityKey;
+    int vertexId;
+    int fromVertex;
+};
+
+static bool ExternalQueueEntryGreater(const ExternalQueueEntry& a, const ExternalQueueEntry& b)
+{
+    return a.priorityKey > b.priorityKey;
+}
+
+// A sorted run spilled to its own file, read back one block at a time.
+struct ExternalQueueRun
+{
+    std::string path;
+    std::ifstream in;
+    long long entriesOnDisk;
+    int level;
+    std::vector<ExternalQueueEntry> block;
+    int blockPosition;
+};
+
+// I/O-efficient priority queue in the style of a sequence heap. Inserts go into an in-memory
+// binary heap; when that reaches its capacity it is sorted and written out as a run. DeleteMin
+// takes the smaller of the in-memory minimum and the heads of the runs. Spilled runs start at
+// level 0; whenever mergeFanIn runs share a level they are merged into one run of the next
+// level, so each entry is rewritten O(log_fanIn(N / capacity)) times and few runs stay open.
+// There is no DecreaseKey: callers insert a new entry and skip stale ones when they pop.
+class ExternalPriorityQueue
+{
+private:
+    std::vector<ExternalQueueEntry> insertionHeap;
+    std::vector<ExternalQueueRun*> runs;
+    std::string spillPathPrefix;
+    int insertionCapacity;
+    int blockEntries;
+    int mergeFanIn;
+    int nextRunId;
+    long long entryCount;
+
+    void SpillInsertionHeap();
+    void MergeRunsAtLevel(int level);
+    ExternalQueueRun* CreateRun(const std::vector<ExternalQueueEntry>& sortedEntries);
+    void StartReadingRun(ExternalQueueRun* run);
+    bool RefillRunBlock(ExternalQueueRun* run);
+    void DestroyRun(ExternalQueueRun* run);
+
+public:
+    ExternalPriorityQueue(const std::string& spillPathPrefix, int insertionCapacity, int blockEntries, int mergeFanIn);
+    ~ExternalPriorityQueue();
+
+    ExternalPriorityQueue(const ExternalPriorityQueue&) = delete;
+    ExternalPriorityQueue& operator=(const ExternalPriorityQueue&) = delete;
+
+    void Insert(const ExternalQueueEntry& entry);
+    ExternalQueueEntry DeleteMin();
+    long long Count();
+    int RunCount();
+};
+
+ExternalPriorityQueue::ExternalPriorityQueue(const std::string& spillPathPrefix, int insertionCapacity, int blockEntries, int mergeFanIn)
+{
+    if (insertionCapacity < 1 || blockEntries < 1 || mergeFanIn < 2)
+    {
+        throw std::runtime_error("ExternalPriorityQueue needs capacity >= 1, block >= 1 and fan-in >= 2");
+    }
+
+    this->spillPathPrefix = spillPathPrefix;
+    this->insertionCapacity = insertionCapacity;
+    this->blockEntries = blockEntries;
+    this->mergeFanIn = mergeFanIn;
+    nextRunId = 0;
+    entryCount = 0;
+    insertionHeap.reserve(insertionCapacity);
+}
+
+ExternalPriorityQueue::~ExternalPriorityQueue()
+{
+    for (int runIndex = 0; runIndex < (int)runs.size(); runIndex++)
+    {
+        DestroyRun(runs[runIndex]);
+    }
+}
+
+void ExternalPriorityQueue::Insert(const ExternalQueueEntry& entry)
+{
+    if ((int)insertionHeap.size() >= insertionCapacity)
+    {
+        SpillInsertionHeap();
+    }
+
+    insertionHeap.push_back(entry);
+    std::push_heap(insertionHeap.begin(), insertionHeap.end(), ExternalQueueEntryGreater);
+    entryCount++;
+}
+
+ExternalQueueEntry ExternalPriorityQueue::DeleteMin()
+{
+    if (entryCount == 0)
+    {
+        throw std::runtime_error("DeleteMin on empty heap");
+    }
+
+    int bestRun = -1;
+    for (int runIndex = 0; runIndex < (int)runs.size(); runIndex++)
+    {
+        ExternalQueueRun* run = runs[runIndex];
+        if (bestRun < 0 ||
+            run->block[run->blockPosition].priorityKey < runs[bestRun]->block[runs[bestRun]->blockPosition].priorityKey)
+        {
+            bestRun = runIndex;
+        }
+    }
+
+    ExternalQueueEntry result;
+
+    if (bestRun < 0 ||
+        (!insertionHeap.empty() && insertionHeap.front().priorityKey <= runs[bestRun]->block[runs[bestRun]->blockPosition].priorityKey))
+    {
+        std::pop_heap(insertionHeap.begin(), insertionHeap.end(), ExternalQueueEntryGreater);
+        result = insertionHeap.back();
+        insertionHeap.pop_back();
+    }
+    else
+    {
+        ExternalQueueRun* run = runs[bestRun];
+        result = run->block[run->blockPosition];
+        run->blockPosition++;
+
+        if (!RefillRunBlock(run))
+        {
+            DestroyRun(run);
+            runs.erase(runs.begin() + bestRun);
+        }
+    }
+
+    entryCount--;
+    return result;
+}
+
+long long ExternalPriorityQueue::Count()
+{
+    return entryCount;
+}
+
+int ExternalPriorityQueue::RunCount()
+{
+    return (int)runs.size();
+}
+
+void ExternalPriorityQueue::SpillInsertionHeap()
+{
+    std::sort_heap(insertionHeap.begin(), insertionHeap.end(), ExternalQueueEntryGreater);
+    std::reverse(insertionHeap.begin(), insertionHeap.end());
+
+    ExternalQueueRun* run = CreateRun(insertionHeap);
+    insertionHeap.clear();
+    runs.push_back(run);
+
+    for (int level = 0;; level++)
+    {
+        int runsAtLevel = 0;
+        for (int runIndex = 0; runIndex < (int)runs.size(); runIndex++)
+        {
+            if (runs[runIndex]->level == level)
+            {
+                runsAtLevel++;
+            }
+        }
+
+        if (runsAtLevel < mergeFanIn)
+        {
+            break;
+        }
+        MergeRunsAtLevel(level);
+    }
+}
+
+void ExternalPriorityQueue::MergeRunsAtLevel(int level)
+{
+    std::vector<ExternalQueueRun*> inputs;
+    std::vector<ExternalQueueRun*> untouched;
+    for (int runIndex = 0; runIndex < (int)runs.size(); runIndex++)
+    {
+        if (runs[runIndex]->level == level)
+        {
+            inputs.push_back(runs[runIndex]);
+        }
+        else
+        {
+            untouched.push_back(runs[runIndex]);
+        }
+    }
+    runs = untouched;
+
+    std::string path = spillPathPrefix + ".run" + std::to_string(nextRunId++);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error("Cannot create spill file " + path);
+    }
+
+    std::vector<ExternalQueueEntry> outputBlock;
+    outputBlock.reserve(blockEntries);
+    long long mergedCount = 0;
+
+    while (!inputs.empty())
+    {
+        int bestRun = 0;
+        for (int runIndex = 1; runIndex < (int)inputs.size(); runIndex++)
+        {
+            if (inputs[runIndex]->block[inputs[runIndex]->blockPosition].priorityKey <
+                inputs[bestRun]->block[inputs[bestRun]->blockPosition].priorityKey)
+            {
+                bestRun = runIndex;
+            }
+        }
+
+        ExternalQueueRun* run = inputs[bestRun];
+        outputBlock.push_back(run->block[run->blockPosition]);
+        run->blockPosition++;
+        mergedCount++;
+
+        if ((int)outputBlock.size() == blockEntries)
+        {
+            CountedWrite(out, outputBlock.data(), (long long)outputBlock.size() * (long long)sizeof(ExternalQueueEntry));
+            outputBlock.clear();
+        }
+
+        if (!RefillRunBlock(run))
+        {
+            DestroyRun(run);
+            inputs.erase(inputs.begin() + bestRun);
+        }
+    }
+
+    if (!outputBlock.empty())
+    {
+        CountedWrite(out, outputBlock.data(), (long long)outputBlock.size() * (long long)sizeof(ExternalQueueEntry));
+    }
+    out.close();
+
+    ExternalQueueRun* merged = new ExternalQueueRun();
+    merged->path = path;
+    merged->entriesOnDisk = mergedCount;
+    merged->level = level + 1;
+    StartReadingRun(merged);
+    runs.push_back(merged);
+}
+
+ExternalQueueRun* ExternalPriorityQueue::CreateRun(const std::vector<ExternalQueueEntry>& sortedEntries)
+{
+    std::string path = spillPathPrefix + ".run" + std::to_string(nextRunId++);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error("Cannot create spill file " + path);
+    }
+
+    ExternalQueueRun* run = new ExternalQueueRun();
+    run->path = path;
+    run->entriesOnDisk = (long long)sortedEntries.size();
+    run->level = 0;
+
+    CountedWrite(out, sortedEntries.data(), (long long)sortedEntries.size() * (long long)sizeof(ExternalQueueEntry));
+    out.close();
+
+    StartReadingRun(run);
+    return run;
+}
+
+void ExternalPriorityQueue::StartReadingRun(ExternalQueueRun* run)
+{
+    run->in.open(run->path, std::ios::binary);
+    if (!run->in)
+    {
+        throw std::runtime_error("Cannot reopen spill file " + run->path);
+    }
+    run->blockPosition = 0;
+    run->block.clear();
+    RefillRunBlock(run);
+}
+
+// Makes sure the run's current block has an unread entry. Returns false once the run is exhausted.
+bool ExternalPriorityQueue::RefillRunBlock(ExternalQueueRun* run)
+{
+    if (run->blockPosition < (int)run->block.size())
+    {
+        return true;
+    }
+    if (run->entriesOnDisk == 0)
+    {
+        return false;
+    }
+
+    long long readCount = std::min<long long>(blockEntries, run->entriesOnDisk);
+    run->block.resize(readCount);
+    CountedRead(run->in, run->block.data(), readCount * (long long)sizeof(ExternalQueueEntry));
+    run->entriesOnDisk -= readCount;
+    run->blockPosition = 0;
+    return true;
+}
+
+void ExternalPriorityQueue::DestroyRun(ExternalQueueRun* run)
+{
+    run->in.close();
+    std::remove(run->path.c_str());
+    delete run;
+}
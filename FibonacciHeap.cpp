@@ -3,21 +3,20 @@
 #include <stdexcept>
 #include <chrono>
 
-struct FibonacciHeapStats
-{
-    long long insertCount;
-    long long deleteMinCount;
-    long long decreaseKeyCount;
-    long long insertNs;
-    long long deleteMinNs;
-    long long decreaseKeyNs;
-};
+#ifndef UNITY_BUILD
+#include "LatencyHistogram.cpp"
+#include "MemoryAllocation.cpp"
+#include "Prefetch.cpp"
+#endif
+
+typedef HeapOperationStats FibonacciHeapStats;
 
-static FibonacciHeapStats fibonacciHeapStats = {0, 0, 0, 0, 0, 0};
+// Per thread, so heaps running on different worker threads do not share histograms.
+static thread_local FibonacciHeapStats fibonacciHeapStats;
 
 static void ResetFibonacciHeapStats()
 {
-    fibonacciHeapStats = {0, 0, 0, 0, 0, 0};
+    fibonacciHeapStats = FibonacciHeapStats();
 }
 
 static FibonacciHeapStats GetFibonacciHeapStats()
@@ -57,6 +56,12 @@ class FibonacciHeap
 private:
     FibonacciHeapNode* minNode;
     int nodeCount;
+    HeapNodePool<FibonacciHeapNode> nodePool;
+
+    // Parents that lost a child to StageDecreaseKey and owe a cascading cut, and the smallest
+    // root a stage produced; both are settled by ApplyStagedDecreaseKeys.
+    std::vector<FibonacciHeapNode*> pendingCascadingCuts;
+    FibonacciHeapNode* stagedMinimum;
 
     void Link(FibonacciHeapNode* y, FibonacciHeapNode* x);
     void Consolidate();
@@ -73,19 +78,77 @@ public:
     FibonacciHeapNode* DeleteMin();
     void DecreaseKey(FibonacciHeapNode* node, int newKey);
     int Count();
+
+    // Batched decrease-key. StageDecreaseKey cuts the node to the root list right away but
+    // leaves the cascading cut and the minimum update to ApplyStagedDecreaseKeys, which runs them
+    // for the whole batch. FindMin, DeleteMin and Meld apply pending stages of the heaps involved
+    // first.
+    void StageDecreaseKey(FibonacciHeapNode* node, int newKey);
+    void ApplyStagedDecreaseKeys();
+
+    // Splices the root list of other into this one in O(1) and leaves other empty. Handles into
+    // other stay valid and now belong to this heap, which also takes over other's node storage.
+    void Meld(FibonacciHeap& other);
+
+    // Returns a node handed out by DeleteMin to the pool. Nodes are owned by the heap and the
+    // remaining ones are freed with it, so callers must not delete them.
+    void ReleaseNode(FibonacciHeapNode* node)
+    {
+        nodePool.Release(node);
+    }
+
+    // Drops every node still in the heap, staged work included, without timing or counting
+    // anything; handles into the heap become invalid.
+    void Clear()
+    {
+        minNode = nullptr;
+        nodeCount = 0;
+        pendingCascadingCuts.clear();
+        stagedMinimum = nullptr;
+        nodePool.Clear();
+    }
+
+    // Calls visit on every node still in the heap, in no particular order and without timing or
+    // counting anything. visit must not change the heap.
+    template <typename Visitor>
+    void ForEachNode(Visitor visit) const
+    {
+        std::vector<FibonacciHeapNode*> pendingLists;
+        if (minNode != nullptr)
+        {
+            pendingLists.push_back(minNode);
+        }
+
+        while (!pendingLists.empty())
+        {
+            FibonacciHeapNode* first = pendingLists.back();
+            pendingLists.pop_back();
+            FibonacciHeapNode* node = first;
+            do
+            {
+                visit(node);
+                if (node->child != nullptr)
+                {
+                    pendingLists.push_back(node->child);
+                }
+                node = node->right;
+            } while (node != first);
+        }
+    }
 };
 
 FibonacciHeap::FibonacciHeap()
 {
     minNode = nullptr;
     nodeCount = 0;
+    stagedMinimum = nullptr;
 }
 
 FibonacciHeapNode* FibonacciHeap::Insert(int key, int vertexId)
 {
     auto startTime = std::chrono::steady_clock::now();
 
-    FibonacciHeapNode* node = new FibonacciHeapNode(key, vertexId);
+    FibonacciHeapNode* node = nodePool.Allocate(key, vertexId);
 
     if (minNode == nullptr)
     {
@@ -104,14 +167,15 @@ FibonacciHeapNode* FibonacciHeap::Insert(int key, int vertexId)
     nodeCount++;
 
     auto endTime = std::chrono::steady_clock::now();
-    fibonacciHeapStats.insertCount = fibonacciHeapStats.insertCount + 1;
-    fibonacciHeapStats.insertNs = fibonacciHeapStats.insertNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    fibonacciHeapStats.insertLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
 
     return node;
 }
 
 FibonacciHeapNode* FibonacciHeap::FindMin()
 {
+    ApplyStagedDecreaseKeys();
+
     if (minNode == nullptr)
     {
         throw std::runtime_error("FindMin on empty heap");
@@ -121,6 +185,8 @@ FibonacciHeapNode* FibonacciHeap::FindMin()
 
 FibonacciHeapNode* FibonacciHeap::DeleteMin()
 {
+    ApplyStagedDecreaseKeys();
+
     auto startTime = std::chrono::steady_clock::now();
 
     if (minNode == nullptr)
@@ -137,6 +203,7 @@ FibonacciHeapNode* FibonacciHeap::DeleteMin()
         do
         {
             FibonacciHeapNode* next = child->right;
+            PQ_PREFETCH_WRITE(next->right);
             AddToRootList(child);
             child->parent = nullptr;
             child = next;
@@ -164,8 +231,7 @@ FibonacciHeapNode* FibonacciHeap::DeleteMin()
     oldMin->child = nullptr;
 
     auto endTime = std::chrono::steady_clock::now();
-    fibonacciHeapStats.deleteMinCount = fibonacciHeapStats.deleteMinCount + 1;
-    fibonacciHeapStats.deleteMinNs = fibonacciHeapStats.deleteMinNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    fibonacciHeapStats.deleteMinLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
 
     return oldMin;
 }
@@ -194,8 +260,65 @@ void FibonacciHeap::DecreaseKey(FibonacciHeapNode* node, int newKey)
     }
 
     auto endTime = std::chrono::steady_clock::now();
-    fibonacciHeapStats.decreaseKeyCount = fibonacciHeapStats.decreaseKeyCount + 1;
-    fibonacciHeapStats.decreaseKeyNs = fibonacciHeapStats.decreaseKeyNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    fibonacciHeapStats.decreaseKeyLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+}
+
+void FibonacciHeap::StageDecreaseKey(FibonacciHeapNode* node, int newKey)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (newKey >= node->priorityKey)
+    {
+        throw std::runtime_error("New key is not smaller than current key in StageDecreaseKey");
+    }
+
+    node->priorityKey = newKey;
+    FibonacciHeapNode* p = node->parent;
+
+    if (p != nullptr && node->priorityKey < p->priorityKey)
+    {
+        Cut(node, p);
+        pendingCascadingCuts.push_back(p);
+    }
+
+    // Only roots can become the minimum; a node still below its parent is not one.
+    if (node->parent == nullptr && (stagedMinimum == nullptr || node->priorityKey < stagedMinimum->priorityKey))
+    {
+        stagedMinimum = node;
+    }
+    fibonacciHeapStats.stagedDecreaseKeys++;
+
+    auto endTime = std::chrono::steady_clock::now();
+    fibonacciHeapStats.decreaseKeyLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+}
+
+void FibonacciHeap::ApplyStagedDecreaseKeys()
+{
+    if (stagedMinimum == nullptr && pendingCascadingCuts.empty())
+    {
+        return;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Each entry stands for one lost child, so a parent listed twice is marked and then cut,
+    // exactly as two separate DecreaseKey calls would have done.
+    for (FibonacciHeapNode* parent : pendingCascadingCuts)
+    {
+        CascadingCut(parent);
+    }
+    pendingCascadingCuts.clear();
+
+    // Nodes moved to the root list by the cascade were below some root, so they never undercut
+    // the minimum; only the staged nodes themselves can.
+    if (stagedMinimum != nullptr && stagedMinimum->priorityKey < minNode->priorityKey)
+    {
+        minNode = stagedMinimum;
+    }
+    stagedMinimum = nullptr;
+
+    auto endTime = std::chrono::steady_clock::now();
+    fibonacciHeapStats.decreaseKeyBatchLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
 }
 
 int FibonacciHeap::Count()
@@ -203,6 +326,46 @@ int FibonacciHeap::Count()
     return nodeCount;
 }
 
+void FibonacciHeap::Meld(FibonacciHeap& other)
+{
+    if (&other == this)
+    {
+        return;
+    }
+
+    ApplyStagedDecreaseKeys();
+    other.ApplyStagedDecreaseKeys();
+
+    if (other.minNode != nullptr)
+    {
+        if (minNode == nullptr)
+        {
+            minNode = other.minNode;
+        }
+        else
+        {
+            FibonacciHeapNode* ourRight = minNode->right;
+            FibonacciHeapNode* theirLeft = other.minNode->left;
+
+            minNode->right = other.minNode;
+            other.minNode->left = minNode;
+            theirLeft->right = ourRight;
+            ourRight->left = theirLeft;
+
+            if (other.minNode->priorityKey < minNode->priorityKey)
+            {
+                minNode = other.minNode;
+            }
+        }
+    }
+
+    nodeCount += other.nodeCount;
+    nodePool.Adopt(other.nodePool);
+
+    other.minNode = nullptr;
+    other.nodeCount = 0;
+}
+
 void FibonacciHeap::AddToRootList(FibonacciHeapNode* node)
 {
     node->left = minNode;
@@ -244,7 +407,10 @@ void FibonacciHeap::Link(FibonacciHeapNode* y, FibonacciHeapNode* x)
 
 void FibonacciHeap::Consolidate()
 {
-    int maxDegree = (int)std::log2((double)nodeCount) + 2;
+    // Cascading cuts only bound a root's degree by log_phi(n), which is about
+    // 1.44 * log2(n), so a log2-sized table overflows after many decrease-keys.
+    const double goldenRatio = (1.0 + std::sqrt(5.0)) / 2.0;
+    int maxDegree = (int)(std::log((double)nodeCount) / std::log(goldenRatio)) + 2;
     std::vector<FibonacciHeapNode*> A(maxDegree, nullptr);
 
     std::vector<FibonacciHeapNode*> roots;
@@ -254,11 +420,18 @@ void FibonacciHeap::Consolidate()
     {
         roots.push_back(curr);
         curr = curr->right;
+        PQ_PREFETCH(curr->right);
     }
     while (curr != minNode);
 
     for (int i = 0; i < (int)roots.size(); i++)
     {
+        // Roots are linked in the order they were collected, so the next ones are known.
+        if (i + 2 < (int)roots.size())
+        {
+            PQ_PREFETCH_WRITE(roots[i + 2]);
+        }
+
         FibonacciHeapNode* x = roots[i];
         int d = x->degree;
 
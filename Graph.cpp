@@ -1,5 +1,6 @@
 #include <vector>
 #include <random>
+#include <limits>
 
 struct Edge
 {
@@ -24,19 +25,99 @@ public:
         return static_cast<int>(adj.size());
     }
 
+    long long DirectedEdgeCount() const
+    {
+        return directedEdgeCount;
+    }
+
     int UndirectedEdgeCount() const
     {
-        long long total = 0;
+        return (int)(directedEdgeCount / 2);
+    }
+
+    int Degree(int u) const
+    {
+        return static_cast<int>(adj[u].size());
+    }
+
+    // Graph stores adjacency uncompressed, so the scratch buffer is never touched.
+    const Edge* NeighborEdges(int u, Edge* /*scratch*/) const
+    {
+        return adj[u].data();
+    }
+
+    long long AdjacencyBytes() const
+    {
+        long long total = (long long)(adj.size() * sizeof(std::vector<Edge>));
         for (int u = 0; u < Count(); u++)
         {
-            total += (long long)adj[u].size();
+            total += (long long)(adj[u].capacity() * sizeof(Edge));
         }
-        return (int)(total / 2);
+        return total;
+    }
+
+    // The edge statistics below are kept up to date as edges are added, so they are O(1).
+    // RemoveEdge and SetEdgeWeight only ever widen them: the maximum degree stays an upper bound
+    // and the weight range still covers every edge, which is all that scratch buffers and the
+    // bucket queue window sized from them need. Both weights are 0 in a graph without edges.
+    int MaxDegree() const
+    {
+        return maxDegree;
+    }
+
+    int MinEdgeWeight() const
+    {
+        return directedEdgeCount == 0 ? 0 : minWeight;
+    }
+
+    int MaxEdgeWeight() const
+    {
+        return directedEdgeCount == 0 ? 0 : maxWeight;
     }
 
     void AddEdge(int u, int v, int weight)
     {
         adj[u].push_back(Edge(v, weight));
+        directedEdgeCount++;
+        if ((int)adj[u].size() > maxDegree)
+        {
+            maxDegree = (int)adj[u].size();
+        }
+        IncludeWeight(weight);
+    }
+
+    void RemoveEdge(int u, int edgeIndex)
+    {
+        adj[u].erase(adj[u].begin() + edgeIndex);
+        directedEdgeCount--;
+    }
+
+    void SetEdgeWeight(int u, int edgeIndex, int weight)
+    {
+        adj[u][edgeIndex].weight = weight;
+        IncludeWeight(weight);
+    }
+
+    // For loaders that fill adj directly instead of going through AddEdge. Also tightens the
+    // bounds left behind by RemoveEdge and SetEdgeWeight.
+    void RecomputeEdgeStatistics()
+    {
+        directedEdgeCount = 0;
+        maxDegree = 0;
+        minWeight = std::numeric_limits<int>::max();
+        maxWeight = std::numeric_limits<int>::min();
+        for (int u = 0; u < Count(); u++)
+        {
+            directedEdgeCount += (long long)adj[u].size();
+            if ((int)adj[u].size() > maxDegree)
+            {
+                maxDegree = (int)adj[u].size();
+            }
+            for (int edgeIndex = 0; edgeIndex < (int)adj[u].size(); edgeIndex++)
+            {
+                IncludeWeight(adj[u][edgeIndex].weight);
+            }
+        }
     }
 
     void AddUndirectedEdge(int u, int v, int weight)
@@ -132,4 +213,22 @@ public:
 
         return g;
     }
+
+private:
+    long long directedEdgeCount = 0;
+    int maxDegree = 0;
+    int minWeight = std::numeric_limits<int>::max();
+    int maxWeight = std::numeric_limits<int>::min();
+
+    void IncludeWeight(int weight)
+    {
+        if (weight < minWeight)
+        {
+            minWeight = weight;
+        }
+        if (weight > maxWeight)
+        {
+            maxWeight = weight;
+        }
+    }
 };
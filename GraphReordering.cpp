@@ -0,0 +1,245 @@
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#endif
+
+// A renumbering of the vertices of a graph. newIdForOldVertex[v] is the id v gets in the
+// reordered graph; oldIdForNewVertex is its inverse and maps results back.
+struct VertexOrdering
+{
+    std::vector<int> newIdForOldVertex;
+    std::vector<int> oldIdForNewVertex;
+};
+
+static VertexOrdering MakeVertexOrdering(const std::vector<int>& oldIdForNewVertex)
+{
+    VertexOrdering ordering;
+    ordering.oldIdForNewVertex = oldIdForNewVertex;
+    ordering.newIdForOldVertex.assign(oldIdForNewVertex.size(), -1);
+
+    for (int newId = 0; newId < (int)oldIdForNewVertex.size(); newId++)
+    {
+        ordering.newIdForOldVertex[oldIdForNewVertex[newId]] = newId;
+    }
+
+    return ordering;
+}
+
+static VertexOrdering IdentityOrdering(const Graph& graph)
+{
+    std::vector<int> oldIdForNewVertex(graph.Count());
+    std::iota(oldIdForNewVertex.begin(), oldIdForNewVertex.end(), 0);
+    return MakeVertexOrdering(oldIdForNewVertex);
+}
+
+// Builds the renumbered graph. Each neighbor list is sorted by the new ids so that a vertex's
+// neighbors are also visited in memory order.
+static Graph ApplyVertexOrdering(const Graph& graph, const VertexOrdering& ordering)
+{
+    Graph reordered(graph.Count());
+
+    for (int newId = 0; newId < graph.Count(); newId++)
+    {
+        const std::vector<Edge>& oldEdges = graph.adj[ordering.oldIdForNewVertex[newId]];
+        std::vector<Edge>& newEdges = reordered.adj[newId];
+        newEdges.reserve(oldEdges.size());
+
+        for (int edgeIndex = 0; edgeIndex < (int)oldEdges.size(); edgeIndex++)
+        {
+            reordered.AddEdge(newId, ordering.newIdForOldVertex[oldEdges[edgeIndex].to], oldEdges[edgeIndex].weight);
+        }
+
+        std::sort(newEdges.begin(), newEdges.end(), [](const Edge& a, const Edge& b) { return a.to < b.to; });
+    }
+
+    return reordered;
+}
+
+// Maps a per-vertex array computed on the reordered graph back to original vertex ids.
+static std::vector<int> MapValuesToOriginalIds(const std::vector<int>& valuesByNewId, const VertexOrdering& ordering)
+{
+    std::vector<int> valuesByOldId(valuesByNewId.size());
+
+    for (int newId = 0; newId < (int)valuesByNewId.size(); newId++)
+    {
+        valuesByOldId[ordering.oldIdForNewVertex[newId]] = valuesByNewId[newId];
+    }
+
+    return valuesByOldId;
+}
+
+// Same as MapValuesToOriginalIds for arrays whose values are vertex ids themselves (predecessor
+// and parent arrays); -1 entries are kept.
+static std::vector<int> MapVertexIdsToOriginalIds(const std::vector<int>& vertexIdsByNewId, const VertexOrdering& ordering)
+{
+    std::vector<int> vertexIdsByOldId(vertexIdsByNewId.size());
+
+    for (int newId = 0; newId < (int)vertexIdsByNewId.size(); newId++)
+    {
+        int value = vertexIdsByNewId[newId];
+        vertexIdsByOldId[ordering.oldIdForNewVertex[newId]] = (value < 0) ? value : ordering.oldIdForNewVertex[value];
+    }
+
+    return vertexIdsByOldId;
+}
+
+// Hubs first: vertices sorted by decreasing degree, ties by original id.
+static VertexOrdering DegreeSortedOrdering(const Graph& graph)
+{
+    std::vector<int> oldIdForNewVertex(graph.Count());
+    std::iota(oldIdForNewVertex.begin(), oldIdForNewVertex.end(), 0);
+
+    std::stable_sort(oldIdForNewVertex.begin(), oldIdForNewVertex.end(), [&graph](int a, int b) {
+        return graph.adj[a].size() > graph.adj[b].size();
+    });
+
+    return MakeVertexOrdering(oldIdForNewVertex);
+}
+
+// Reverse Cuthill-McKee. Every component is traversed breadth-first from a minimum-degree
+// vertex, visiting unvisited neighbors in order of increasing degree; the final order is
+// reversed, which keeps the bandwidth and tends to reduce fill further.
+static VertexOrdering CuthillMcKeeOrdering(const Graph& graph)
+{
+    int numberOfVertices = graph.Count();
+
+    std::vector<int> verticesByDegree(numberOfVertices);
+    std::iota(verticesByDegree.begin(), verticesByDegree.end(), 0);
+    std::stable_sort(verticesByDegree.begin(), verticesByDegree.end(), [&graph](int a, int b) {
+        return graph.adj[a].size() < graph.adj[b].size();
+    });
+
+    std::vector<bool> visited(numberOfVertices, false);
+    std::vector<int> order;
+    order.reserve(numberOfVertices);
+    std::vector<int> unvisitedNeighbors;
+
+    for (int seedIndex = 0; seedIndex < numberOfVertices; seedIndex++)
+    {
+        int seed = verticesByDegree[seedIndex];
+        if (visited[seed])
+        {
+            continue;
+        }
+
+        visited[seed] = true;
+        int queueHead = (int)order.size();
+        order.push_back(seed);
+
+        while (queueHead < (int)order.size())
+        {
+            int u = order[queueHead++];
+
+            unvisitedNeighbors.clear();
+            for (int edgeIndex = 0; edgeIndex < (int)graph.adj[u].size(); edgeIndex++)
+            {
+                int v = graph.adj[u][edgeIndex].to;
+                if (!visited[v])
+                {
+                    visited[v] = true;
+                    unvisitedNeighbors.push_back(v);
+                }
+            }
+
+            std::sort(unvisitedNeighbors.begin(), unvisitedNeighbors.end(), [&graph](int a, int b) {
+                return graph.adj[a].size() < graph.adj[b].size();
+            });
+            order.insert(order.end(), unvisitedNeighbors.begin(), unvisitedNeighbors.end());
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return MakeVertexOrdering(order);
+}
+
+// Breadth-first search restricted to order[begin, end), whose vertices carry rangeStamp in
+// stamp[]. Rewrites that slice in BFS order from start; vertices unreachable inside the range
+// are appended afterwards in their previous order. Returns the last vertex reached.
+static int BreadthFirstWithinRange(const Graph& graph, std::vector<int>& order, int begin, int end, int start,
+                                   std::vector<int>& stamp, int rangeStamp, int visitedStamp, std::vector<int>& scratch)
+{
+    scratch.clear();
+    scratch.push_back(start);
+    stamp[start] = visitedStamp;
+
+    for (int head = 0; head < (int)scratch.size(); head++)
+    {
+        int u = scratch[head];
+        for (int edgeIndex = 0; edgeIndex < (int)graph.adj[u].size(); edgeIndex++)
+        {
+            int v = graph.adj[u][edgeIndex].to;
+            if (stamp[v] == rangeStamp)
+            {
+                stamp[v] = visitedStamp;
+                scratch.push_back(v);
+            }
+        }
+    }
+
+    int lastReached = scratch.back();
+
+    for (int index = begin; index < end; index++)
+    {
+        if (stamp[order[index]] == rangeStamp)
+        {
+            scratch.push_back(order[index]);
+        }
+    }
+
+    for (int index = begin; index < end; index++)
+    {
+        order[index] = scratch[index - begin];
+        stamp[order[index]] = rangeStamp;
+    }
+
+    return lastReached;
+}
+
+// Recursive bisection: each range of the order is laid out breadth-first from a far vertex
+// (found with a first BFS) and split in half at the median BFS position, so both halves are
+// connected-ish regions. Recursion stops at ranges of leafSize vertices.
+static VertexOrdering RecursiveBisectionOrdering(const Graph& graph, int leafSize = 64)
+{
+    int numberOfVertices = graph.Count();
+
+    std::vector<int> order(numberOfVertices);
+    std::iota(order.begin(), order.end(), 0);
+
+    std::vector<int> stamp(numberOfVertices, 0);
+    std::vector<int> scratch;
+    scratch.reserve(numberOfVertices);
+    int nextStamp = 1;
+
+    std::vector<std::pair<int, int>> pendingRanges;
+    pendingRanges.push_back({0, numberOfVertices});
+
+    while (!pendingRanges.empty())
+    {
+        int begin = pendingRanges.back().first;
+        int end = pendingRanges.back().second;
+        pendingRanges.pop_back();
+
+        if (end - begin <= leafSize)
+        {
+            continue;
+        }
+
+        int rangeStamp = nextStamp++;
+        for (int index = begin; index < end; index++)
+        {
+            stamp[order[index]] = rangeStamp;
+        }
+
+        int farVertex = BreadthFirstWithinRange(graph, order, begin, end, order[begin], stamp, rangeStamp, nextStamp++, scratch);
+        BreadthFirstWithinRange(graph, order, begin, end, farVertex, stamp, rangeStamp, nextStamp++, scratch);
+
+        int middle = begin + (end - begin) / 2;
+        pendingRanges.push_back({middle, end});
+        pendingRanges.push_back({begin, middle});
+    }
+
+    return MakeVertexOrdering(order);
+}
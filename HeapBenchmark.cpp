@@ -0,0 +1,537 @@
+// Standalone heap microbenchmark. Unlike main.cpp, which only sees the heaps through full
+// Dijkstra/Prim runs, every workload here drives one heap directly with a fixed operation mix,
+// so a regression in a single operation shows up on its own. Build it separately:
+//
+//     g++ -std=c++17 -O2 -o heap_benchmark HeapBenchmark.cpp
+//     ./heap_benchmark [--n=50000] [--reps=5] [--warmup=1] [--decrease-ratio=4] [--heap=name]
+//                      [--alloc=policy] [--wide-root-n=10000000]
+//
+// Results go to stdout and heap_benchmark_results.csv.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#define UNITY_BUILD 1
+
+#include "LatencyHistogram.cpp"
+#include "Graph.cpp"
+#include "MemoryAllocation.cpp"
+#include "Prefetch.cpp"
+#include "PairingHeap.cpp"
+#include "FibonacciHeap.cpp"
+#include "BucketQueue.cpp"
+
+enum class KeyOrder
+{
+    Random,
+    Ascending,
+    Descending
+};
+
+static const char* KeyOrderName(KeyOrder order)
+{
+    switch (order)
+    {
+        case KeyOrder::Random:
+            return "random";
+        case KeyOrder::Ascending:
+            return "ascending";
+        case KeyOrder::Descending:
+            return "descending";
+    }
+    return "unknown";
+}
+
+struct HeapBenchmarkOptions
+{
+    int elementCount = 50000;
+    int repetitions = 5;
+    int warmupRepetitions = 1;
+    int decreaseKeyRatio = 4;
+    std::string heapFilter;
+    // Size of the wide_root_delete_min workload; 0 skips it.
+    int wideRootCount = 10000000;
+};
+
+// Keys are spread over [0, 4 * count) so decrease-key workloads have room below each key.
+static std::vector<int> MakeKeys(int count, KeyOrder order, std::mt19937& rng)
+{
+    std::vector<int> keys(count);
+
+    if (order == KeyOrder::Random)
+    {
+        std::uniform_int_distribution<int> keyDist(0, 4 * count);
+        for (int index = 0; index < count; index++)
+        {
+            keys[index] = keyDist(rng);
+        }
+    }
+    else
+    {
+        for (int index = 0; index < count; index++)
+        {
+            keys[index] = 4 * ((order == KeyOrder::Ascending) ? index : count - 1 - index);
+        }
+    }
+
+    return keys;
+}
+
+// Frees whatever is left, outside of the timed region and without touching the heap stats.
+template <typename HeapType, typename HeapNodeType>
+static void DrainHeap(HeapType& heap)
+{
+    heap.Clear();
+}
+
+// A workload runs on a fresh heap, leaves it empty, and returns the number of heap operations
+// it timed; elapsedNs covers only those operations, not setup or cleanup.
+template <typename HeapType, typename HeapNodeType>
+struct HeapWorkload
+{
+    typedef long long (*Function)(HeapType& heap, const std::vector<int>& keys, const HeapBenchmarkOptions& options,
+                                  std::mt19937& rng, long long& elapsedNs);
+
+    const char* name;
+    Function run;
+    bool varyKeyOrder;
+};
+
+template <typename HeapType, typename HeapNodeType>
+static long long InsertWorkload(HeapType& heap, const std::vector<int>& keys, const HeapBenchmarkOptions& /*options*/,
+                                std::mt19937& /*rng*/, long long& elapsedNs)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < (int)keys.size(); index++)
+    {
+        heap.Insert(keys[index], index);
+    }
+    auto end = std::chrono::steady_clock::now();
+    elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    DrainHeap<HeapType, HeapNodeType>(heap);
+    return (long long)keys.size();
+}
+
+// With ascending keys every insert becomes a child of the root, so the first DeleteMin has to
+// combine a root of degree n: the wide-root case for the pairing heap merge strategies.
+template <typename HeapType, typename HeapNodeType>
+static long long InsertDrainWorkload(HeapType& heap, const std::vector<int>& keys, const HeapBenchmarkOptions& /*options*/,
+                                     std::mt19937& /*rng*/, long long& elapsedNs)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < (int)keys.size(); index++)
+    {
+        heap.Insert(keys[index], index);
+    }
+    while (heap.Count() > 0)
+    {
+        heap.ReleaseNode(heap.DeleteMin());
+    }
+    auto end = std::chrono::steady_clock::now();
+    elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    return 2LL * (long long)keys.size();
+}
+
+// Insert-then-drain that also writes the output and checks it is sorted.
+template <typename HeapType, typename HeapNodeType>
+static long long HeapsortWorkload(HeapType& heap, const std::vector<int>& keys, const HeapBenchmarkOptions& /*options*/,
+                                  std::mt19937& /*rng*/, long long& elapsedNs)
+{
+    std::vector<int> sorted(keys.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < (int)keys.size(); index++)
+    {
+        heap.Insert(keys[index], index);
+    }
+    for (int index = 0; index < (int)keys.size(); index++)
+    {
+        HeapNodeType* minimumNode = heap.DeleteMin();
+        sorted[index] = minimumNode->priorityKey;
+        heap.ReleaseNode(minimumNode);
+    }
+    auto end = std::chrono::steady_clock::now();
+    elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    if (!std::is_sorted(sorted.begin(), sorted.end()))
+    {
+        throw std::runtime_error("Heapsort produced unsorted output");
+    }
+    return 2LL * (long long)keys.size();
+}
+
+// Dijkstra-like mix: after building the heap, every DeleteMin is preceded by decreaseKeyRatio
+// DecreaseKey calls on random live nodes, each lowering the key by a random amount.
+template <typename HeapType, typename HeapNodeType>
+static long long DecreaseKeyStormWorkload(HeapType& heap, const std::vector<int>& keys, const HeapBenchmarkOptions& options,
+                                          std::mt19937& rng, long long& elapsedNs)
+{
+    int count = (int)keys.size();
+    std::vector<HeapNodeType*> liveNodes(count);
+    std::vector<int> positionOfVertex(count);
+
+    // Decrease targets and amounts are drawn up front so the generator stays out of the timing;
+    // a target is a rank into the live set, resolved at the time of the call.
+    int decreaseCount = count * options.decreaseKeyRatio;
+    std::vector<unsigned int> targetDraws(decreaseCount);
+    std::vector<int> decreaseAmounts(decreaseCount);
+    std::uniform_int_distribution<int> amountDist(1, 8);
+    for (int index = 0; index < decreaseCount; index++)
+    {
+        targetDraws[index] = (unsigned int)rng();
+        decreaseAmounts[index] = amountDist(rng);
+    }
+
+    long long operations = 0;
+    int decreaseIndex = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < count; index++)
+    {
+        liveNodes[index] = heap.Insert(keys[index], index);
+        positionOfVertex[index] = index;
+    }
+    operations += count;
+
+    int liveCount = count;
+    while (liveCount > 0)
+    {
+        for (int round = 0; round < options.decreaseKeyRatio; round++, decreaseIndex++)
+        {
+            HeapNodeType* target = liveNodes[targetDraws[decreaseIndex] % (unsigned int)liveCount];
+            heap.DecreaseKey(target, target->priorityKey - decreaseAmounts[decreaseIndex]);
+        }
+        operations += options.decreaseKeyRatio;
+
+        HeapNodeType* minimumNode = heap.DeleteMin();
+        int position = positionOfVertex[minimumNode->vertexId];
+        liveNodes[position] = liveNodes[liveCount - 1];
+        positionOfVertex[liveNodes[position]->vertexId] = position;
+        liveCount--;
+        heap.ReleaseNode(minimumNode);
+        operations++;
+    }
+    auto end = std::chrono::steady_clock::now();
+    elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    return operations;
+}
+
+// Adversarial for pairing heaps: repeatedly take a random node, decrease it below the current
+// minimum and delete it. Each cycle cuts a subtree deep in the heap and makes the root combine
+// its children again, so the amortized cost of DecreaseKey shows up in DeleteMin. A fresh key
+// is inserted every cycle to keep the size constant.
+template <typename HeapType, typename HeapNodeType>
+static long long DecreaseDeleteCycleWorkload(HeapType& heap, const std::vector<int>& keys, const HeapBenchmarkOptions& /*options*/,
+                                             std::mt19937& rng, long long& elapsedNs)
+{
+    int count = (int)keys.size();
+    std::vector<HeapNodeType*> liveNodes(count);
+    std::vector<unsigned int> targetDraws(count);
+    for (int index = 0; index < count; index++)
+    {
+        targetDraws[index] = (unsigned int)rng();
+    }
+
+    for (int index = 0; index < count; index++)
+    {
+        liveNodes[index] = heap.Insert(keys[index], index);
+    }
+
+    int nextKey = 4 * count;
+    int lowestKey = -1;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < count; cycle++)
+    {
+        int position = (int)(targetDraws[cycle] % (unsigned int)count);
+        heap.DecreaseKey(liveNodes[position], lowestKey--);
+        heap.ReleaseNode(heap.DeleteMin());
+        liveNodes[position] = heap.Insert(nextKey++, position);
+    }
+    auto end = std::chrono::steady_clock::now();
+    elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    DrainHeap<HeapType, HeapNodeType>(heap);
+    return 3LL * count;
+}
+
+// Adversarial for pairing heaps: decrease every node, from the largest key down, to a new
+// overall minimum. Each decreased node becomes the root with the previous root as its first
+// child, building a long chain of cut-and-relinked nodes before the heap is drained.
+template <typename HeapType, typename HeapNodeType>
+static long long DecreaseToMinimumWorkload(HeapType& heap, const std::vector<int>& keys, const HeapBenchmarkOptions& /*options*/,
+                                           std::mt19937& /*rng*/, long long& elapsedNs)
+{
+    int count = (int)keys.size();
+    std::vector<HeapNodeType*> nodes(count);
+    std::vector<int> orderByKey(count);
+    std::iota(orderByKey.begin(), orderByKey.end(), 0);
+    std::sort(orderByKey.begin(), orderByKey.end(), [&keys](int a, int b) { return keys[a] > keys[b]; });
+
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < count; index++)
+    {
+        nodes[index] = heap.Insert(keys[index], index);
+    }
+    for (int rank = 0; rank < count; rank++)
+    {
+        heap.DecreaseKey(nodes[orderByKey[rank]], -1 - rank);
+    }
+    while (heap.Count() > 0)
+    {
+        heap.ReleaseNode(heap.DeleteMin());
+    }
+    auto end = std::chrono::steady_clock::now();
+    elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    return 3LL * count;
+}
+
+// p99 of one operation over the measured repetitions, or -1 if the workload never ran it.
+static long long OperationP99Ns(const LatencyHistogram& latency)
+{
+    return (latency.Count() == 0) ? -1 : latency.PercentileNs(99.0);
+}
+
+static void WriteResultRow(std::ofstream& out, const std::string& heapName, const char* workloadName,
+                           const char* keyOrderName, const HeapBenchmarkOptions& options,
+                           long long operations, std::vector<double> nsPerOp, const HeapOperationStats& stats)
+{
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    double medianNs = nsPerOp[nsPerOp.size() / 2];
+    double minimumNs = nsPerOp.front();
+    double opsPerSecond = 1e9 / medianNs;
+
+    out << heapName << "," << workloadName << "," << keyOrderName << ","
+        << options.elementCount << "," << options.decreaseKeyRatio << ","
+        << operations << "," << nsPerOp.size() << ","
+        << medianNs << "," << minimumNs << "," << opsPerSecond << ","
+        << OperationP99Ns(stats.insertLatency) << ","
+        << OperationP99Ns(stats.deleteMinLatency) << ","
+        << OperationP99Ns(stats.decreaseKeyLatency) << "\n";
+
+    std::cout << heapName << "  " << workloadName << "  " << keyOrderName
+              << "  median " << medianNs << " ns/op  min " << minimumNs
+              << " ns/op  " << opsPerSecond << " ops/sec"
+              << "  p99 insert " << OperationP99Ns(stats.insertLatency)
+              << " deletemin " << OperationP99Ns(stats.deleteMinLatency)
+              << " decreasekey " << OperationP99Ns(stats.decreaseKeyLatency) << " ns\n";
+}
+
+// Runs every workload on heaps produced by makeHeap. Warmup repetitions are run and discarded;
+// the median and minimum ns/op of the remaining repetitions are reported, along with the p99 of
+// each operation from the heap's own latency histograms over those repetitions.
+template <typename HeapType, typename HeapNodeType, typename MakeHeap>
+static void MeasureHeap(const std::string& heapName, MakeHeap makeHeap, void (*resetStats)(),
+                        HeapOperationStats (*getStats)(), const HeapBenchmarkOptions& options, std::ofstream& out)
+{
+    if (!options.heapFilter.empty() && options.heapFilter != heapName)
+    {
+        return;
+    }
+
+    const HeapWorkload<HeapType, HeapNodeType> workloads[] = {
+        {"insert", InsertWorkload<HeapType, HeapNodeType>, true},
+        {"insert_drain", InsertDrainWorkload<HeapType, HeapNodeType>, true},
+        {"heapsort", HeapsortWorkload<HeapType, HeapNodeType>, false},
+        {"decrease_key_storm", DecreaseKeyStormWorkload<HeapType, HeapNodeType>, false},
+        {"adversarial_decrease_delete", DecreaseDeleteCycleWorkload<HeapType, HeapNodeType>, false},
+        {"adversarial_decrease_to_min", DecreaseToMinimumWorkload<HeapType, HeapNodeType>, false},
+    };
+    const KeyOrder keyOrders[3] = {KeyOrder::Random, KeyOrder::Ascending, KeyOrder::Descending};
+
+    for (const HeapWorkload<HeapType, HeapNodeType>& workload : workloads)
+    {
+        int keyOrderCount = workload.varyKeyOrder ? 3 : 1;
+
+        for (int keyOrderIndex = 0; keyOrderIndex < keyOrderCount; keyOrderIndex++)
+        {
+            std::vector<double> nsPerOp;
+            long long operations = 0;
+
+            for (int repetition = 0; repetition < options.warmupRepetitions + options.repetitions; repetition++)
+            {
+                std::mt19937 rng(7000 + repetition);
+                std::vector<int> keys = MakeKeys(options.elementCount, keyOrders[keyOrderIndex], rng);
+
+                if (repetition == options.warmupRepetitions)
+                {
+                    resetStats();
+                }
+
+                HeapType heap = makeHeap();
+                long long elapsedNs = 0;
+                operations = workload.run(heap, keys, options, rng, elapsedNs);
+
+                if (repetition >= options.warmupRepetitions)
+                {
+                    nsPerOp.push_back((double)elapsedNs / (double)operations);
+                }
+            }
+
+            WriteResultRow(out, heapName, workload.name, KeyOrderName(keyOrders[keyOrderIndex]), options, operations, nsPerOp,
+                           getStats());
+        }
+    }
+}
+
+// Inserts wideRootCount ascending keys and times the single DeleteMin that follows. Eager pairing
+// heaps hang every insert off the root, the lazy one keeps them all in its auxiliary list and
+// the Fibonacci heap keeps them all as roots, so that DeleteMin combines one list of about
+// wideRootCount nodes. At 10M nodes any merge that recurses per sibling overflows the stack,
+// which is what this guards against. Runs once: the build alone takes seconds.
+template <typename HeapType, typename HeapNodeType, typename MakeHeap>
+static void MeasureWideRoot(const std::string& heapName, MakeHeap makeHeap, void (*resetStats)(),
+                            HeapOperationStats (*getStats)(), const HeapBenchmarkOptions& options, std::ofstream& out)
+{
+    if (options.wideRootCount <= 0 || (!options.heapFilter.empty() && options.heapFilter != heapName))
+    {
+        return;
+    }
+
+    HeapType heap = makeHeap();
+    for (int index = 0; index < options.wideRootCount; index++)
+    {
+        heap.Insert(index, index);
+    }
+
+    resetStats();
+    auto start = std::chrono::steady_clock::now();
+    HeapNodeType* minimumNode = heap.DeleteMin();
+    auto end = std::chrono::steady_clock::now();
+
+    if (minimumNode->priorityKey != 0 || heap.FindMin()->priorityKey != 1)
+    {
+        throw std::runtime_error("wide_root_delete_min returned the wrong minimum");
+    }
+    heap.ReleaseNode(minimumNode);
+    heap.Clear();
+
+    HeapBenchmarkOptions rowOptions = options;
+    rowOptions.elementCount = options.wideRootCount;
+    double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    WriteResultRow(out, heapName, "wide_root_delete_min", KeyOrderName(KeyOrder::Ascending), rowOptions, 1,
+                   std::vector<double>(1, elapsedNs), getStats());
+}
+
+int main(int argc, char** argv)
+{
+    HeapBenchmarkOptions options;
+
+    for (int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        const char* arg = argv[argIndex];
+        if (std::strncmp(arg, "--n=", 4) == 0)
+        {
+            options.elementCount = std::max(1, std::atoi(arg + 4));
+        }
+        else if (std::strncmp(arg, "--reps=", 7) == 0)
+        {
+            options.repetitions = std::max(1, std::atoi(arg + 7));
+        }
+        else if (std::strncmp(arg, "--warmup=", 9) == 0)
+        {
+            options.warmupRepetitions = std::max(0, std::atoi(arg + 9));
+        }
+        else if (std::strncmp(arg, "--decrease-ratio=", 17) == 0)
+        {
+            options.decreaseKeyRatio = std::max(0, std::atoi(arg + 17));
+        }
+        else if (std::strncmp(arg, "--wide-root-n=", 14) == 0)
+        {
+            options.wideRootCount = std::max(0, std::atoi(arg + 14));
+        }
+        else if (std::strncmp(arg, "--heap=", 7) == 0)
+        {
+            options.heapFilter = arg + 7;
+        }
+        else if (std::strncmp(arg, "--alloc=", 8) == 0)
+        {
+            AllocationPolicy policy;
+            if (!ParseAllocationPolicy(arg + 8, policy))
+            {
+                std::cerr << "Unknown allocation policy: " << (arg + 8) << "\n";
+                return 1;
+            }
+            SetAllocationPolicy(policy);
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << "node pools: " << AllocationPolicyName(activeAllocationPolicy) << "\n";
+    ResetAllocationStats();
+    std::cout << "prefetch: " << (PQ_PREFETCH_ENABLED ? "on" : "off") << "\n";
+
+    std::ofstream out("heap_benchmark_results.csv");
+    out << "heap,workload,key_order,n,decrease_ratio,ops,reps,ns_per_op_median,ns_per_op_min,ops_per_sec,"
+           "insert_p99_ns,deletemin_p99_ns,decreasekey_p99_ns\n";
+
+    const PairingHeapMergeStrategy pairingStrategies[] = {
+        PairingHeapMergeStrategy::TwoPass,
+        PairingHeapMergeStrategy::Multipass,
+        PairingHeapMergeStrategy::FrontToBack,
+        PairingHeapMergeStrategy::Lazy,
+        PairingHeapMergeStrategy::RecursiveTwoPass,
+    };
+
+    for (PairingHeapMergeStrategy strategy : pairingStrategies)
+    {
+        // The recursive baseline recurses once per sibling pair and overflows the stack on the
+        // wide roots that ascending inserts produce.
+        if (strategy == PairingHeapMergeStrategy::RecursiveTwoPass && options.elementCount > 100000)
+        {
+            std::cout << "skipping " << PairingHeapMergeStrategyName(strategy) << " above n=100000\n";
+            continue;
+        }
+
+        MeasureHeap<PairingHeap, PairingHeapNode>(
+            PairingHeapMergeStrategyName(strategy), [strategy]() { return PairingHeap(strategy); },
+            ResetPairingHeapStats, GetPairingHeapStats, options, out);
+
+        if (strategy == PairingHeapMergeStrategy::RecursiveTwoPass)
+        {
+            std::cout << "skipping " << PairingHeapMergeStrategyName(strategy) << " wide_root_delete_min\n";
+            continue;
+        }
+        MeasureWideRoot<PairingHeap, PairingHeapNode>(
+            PairingHeapMergeStrategyName(strategy), [strategy]() { return PairingHeap(strategy); },
+            ResetPairingHeapStats, GetPairingHeapStats, options, out);
+    }
+
+    MeasureHeap<FibonacciHeap, FibonacciHeapNode>("fibonacci", []() { return FibonacciHeap(); },
+                                                  ResetFibonacciHeapStats, GetFibonacciHeapStats, options, out);
+    MeasureWideRoot<FibonacciHeap, FibonacciHeapNode>("fibonacci", []() { return FibonacciHeap(); },
+                                                      ResetFibonacciHeapStats, GetFibonacciHeapStats, options, out);
+
+    // Workload keys start in [0, 4n], drop to about -n and are refilled up to 5n, so a window of
+    // 8n keeps every key bucketed and no workload goes through the overflow list.
+    int bucketKeySpread = 8 * options.elementCount;
+    MeasureHeap<BucketQueue, BucketQueueNode>("bucket", [bucketKeySpread]() { return BucketQueue(bucketKeySpread); },
+                                              ResetBucketQueueStats, GetBucketQueueStats, options, out);
+
+    // Node pools map their chunks through the allocation policy; this shows what that amounted
+    // to over the whole run and how much of the process the kernel backs with huge pages.
+    AllocationStats allocation = GetAllocationStats();
+    std::cout << "node pool regions mapped: " << allocation.regionsMapped << " (" << allocation.bytesMapped
+              << " bytes), hugetlb fallbacks: " << allocation.hugeTlbFallbacks
+              << ", advise failures: " << allocation.adviseFailures
+              << ", anon huge pages: " << AnonHugePageBytes() << " bytes\n";
+
+    return 0;
+}
@@ -0,0 +1,376 @@
+#include <vector>
+#include <string>
+#include <utility>
+#include <limits>
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#include "PairingHeap.cpp"
+#include "FibonacciHeap.cpp"
+#include "BucketQueue.cpp"
+#include "Dijkstra.cpp"
+#include "Prim.cpp"
+#endif
+
+// Statistics used to pick a priority queue. Every graph type keeps them as it is built, so a
+// profile is O(1). The weight range has to cover every edge: it sizes the bucket queue window,
+// and a single edge heavier than the window sends keys to the overflow list, whose refills
+// rescan every undiscovered vertex.
+struct GraphProfile
+{
+    int vertices = 0;
+    long long edges = 0;
+    double averageDegree = 0.0;
+    int maxDegree = 0;
+    int minWeight = 0;
+    int maxWeight = 0;
+};
+
+template <typename GraphType>
+static GraphProfile ProfileGraph(const GraphType& graph)
+{
+    GraphProfile profile;
+    profile.vertices = graph.Count();
+    if (profile.vertices == 0)
+    {
+        return profile;
+    }
+
+    profile.edges = graph.DirectedEdgeCount();
+    profile.averageDegree = (double)profile.edges / profile.vertices;
+    profile.maxDegree = graph.MaxDegree();
+    profile.minWeight = graph.MinEdgeWeight();
+    profile.maxWeight = graph.MaxEdgeWeight();
+    return profile;
+}
+
+enum class HeapKind
+{
+    Pairing,
+    Fibonacci,
+    Bucket
+};
+
+enum class AutoHeapAlgorithm
+{
+    Dijkstra,
+    Prim
+};
+
+struct HeapSelection
+{
+    HeapKind kind = HeapKind::Pairing;
+    PairingHeapMergeStrategy pairingStrategy = PairingHeapMergeStrategy::TwoPass;
+    int bucketKeySpread = 0;
+    GraphProfile profile;
+    const char* reason = "";
+    bool calibrated = false;
+    long long calibrationUs = 0;
+};
+
+// Same names as the heap column of results.csv.
+static const char* HeapSelectionName(const HeapSelection& selection)
+{
+    switch (selection.kind)
+    {
+        case HeapKind::Bucket:
+            return "bucket";
+        case HeapKind::Fibonacci:
+            return "fibonacci";
+        case HeapKind::Pairing:
+            return PairingHeapMergeStrategyName(selection.pairingStrategy);
+    }
+    return "unknown";
+}
+
+// The bucket array costs one pointer per possible key in the window and DeleteMin may walk all
+// of it, so the bucket queue is only picked while the window is small next to the graph.
+static const int BUCKET_QUEUE_MAX_SPREAD = 1 << 16;
+
+// A vertex this many times above the average degree marks a hub-heavy graph like
+// synthetic_worst, where most work is decrease-keys from a few vertices.
+static const int HUB_DEGREE_FACTOR = 32;
+
+// Rules distilled from summary.csv and the bucket queue runs: the bucket queue wins whenever
+// weights are small non-negative integers; otherwise two-pass pairing is the best or within
+// noise of the best everywhere except hub-heavy graphs, where multipass pairing and Fibonacci
+// lead. Front-to-back and the recursive baseline are never picked: both degrade badly on some
+// inputs (see heap_benchmark).
+static HeapSelection SelectHeapForProfile(const GraphProfile& profile)
+{
+    HeapSelection selection;
+    selection.profile = profile;
+
+    if (profile.minWeight >= 0 && profile.maxWeight <= BUCKET_QUEUE_MAX_SPREAD &&
+        profile.maxWeight <= std::max(profile.vertices, 1024))
+    {
+        selection.kind = HeapKind::Bucket;
+        selection.bucketKeySpread = profile.maxWeight;
+        selection.reason = "small non-negative integer weights";
+    }
+    else if (profile.averageDegree > 0.0 && profile.maxDegree >= HUB_DEGREE_FACTOR * profile.averageDegree)
+    {
+        selection.kind = HeapKind::Pairing;
+        selection.pairingStrategy = PairingHeapMergeStrategy::Multipass;
+        selection.reason = "hub vertices dominate the decrease-keys";
+    }
+    else
+    {
+        selection.kind = HeapKind::Pairing;
+        selection.pairingStrategy = PairingHeapMergeStrategy::TwoPass;
+        selection.reason = "general weights";
+    }
+    return selection;
+}
+
+template <typename GraphType>
+static std::pair<std::vector<int>, std::vector<int>>
+DijkstraUsingHeapSelection(const GraphType& graph, int sourceVertex, const HeapSelection& selection)
+{
+    switch (selection.kind)
+    {
+        case HeapKind::Bucket:
+            return DijkstraUsingBucketQueue(graph, sourceVertex, selection.bucketKeySpread);
+        case HeapKind::Fibonacci:
+            return DijkstraUsingFibonacciHeap(graph, sourceVertex);
+        default:
+            return DijkstraUsingPairingHeap(graph, sourceVertex, selection.pairingStrategy);
+    }
+}
+
+template <typename GraphType>
+static std::pair<std::vector<int>, int>
+PrimUsingHeapSelection(const GraphType& graph, int startVertex, const HeapSelection& selection)
+{
+    switch (selection.kind)
+    {
+        case HeapKind::Bucket:
+            return PrimUsingBucketQueue(graph, startVertex, selection.bucketKeySpread);
+        case HeapKind::Fibonacci:
+            return PrimUsingFibonacciHeap(graph, startVertex);
+        default:
+            return PrimUsingPairingHeap(graph, startVertex, selection.pairingStrategy);
+    }
+}
+
+// Stats of the heap a selection runs on, for callers that reset all three before the run.
+static HeapOperationStats GetSelectedHeapStats(const HeapSelection& selection)
+{
+    switch (selection.kind)
+    {
+        case HeapKind::Bucket:
+            return GetBucketQueueStats();
+        case HeapKind::Fibonacci:
+            return GetFibonacciHeapStats();
+        default:
+            return GetPairingHeapStats();
+    }
+}
+
+// The calibration sample is 1/CALIBRATION_SAMPLE_FRACTION of the graph, clamped to
+// [CALIBRATION_MIN_SAMPLE, CALIBRATION_MAX_SAMPLE] vertices. Every candidate runs
+// CALIBRATION_ROUNDS times on it, so calibration costs roughly a quarter of one full run on large
+// graphs, but several full runs on graphs not much bigger than the minimum sample.
+static const int CALIBRATION_SAMPLE_FRACTION = 64;
+static const int CALIBRATION_MIN_SAMPLE = 512;
+static const int CALIBRATION_MAX_SAMPLE = 4096;
+static const int CALIBRATION_ROUNDS = 3;
+
+// Induced subgraph on the first sampleVertices vertices reached by BFS from startVertex, so the
+// sample keeps the local degree and weight structure the real run will see first.
+template <typename GraphType>
+static Graph SampleSubgraph(const GraphType& graph, int startVertex, int sampleVertices)
+{
+    int numberOfVertices = graph.Count();
+    std::vector<int> sampleIdOfVertex(numberOfVertices, -1);
+    std::vector<int> sampledVertices;
+    std::vector<Edge> decodedEdges(graph.MaxDegree(), Edge(0, 0));
+
+    sampleIdOfVertex[startVertex] = 0;
+    sampledVertices.push_back(startVertex);
+
+    for (size_t head = 0; head < sampledVertices.size() && (int)sampledVertices.size() < sampleVertices; head++)
+    {
+        int u = sampledVertices[head];
+        const Edge* edges = graph.NeighborEdges(u, decodedEdges.data());
+        int degree = graph.Degree(u);
+        for (int edgeIndex = 0; edgeIndex < degree && (int)sampledVertices.size() < sampleVertices; edgeIndex++)
+        {
+            int v = edges[edgeIndex].to;
+            if (sampleIdOfVertex[v] < 0)
+            {
+                sampleIdOfVertex[v] = (int)sampledVertices.size();
+                sampledVertices.push_back(v);
+            }
+        }
+    }
+
+    Graph sample((int)sampledVertices.size());
+    for (int sampleId = 0; sampleId < (int)sampledVertices.size(); sampleId++)
+    {
+        int u = sampledVertices[sampleId];
+        const Edge* edges = graph.NeighborEdges(u, decodedEdges.data());
+        int degree = graph.Degree(u);
+        for (int edgeIndex = 0; edgeIndex < degree; edgeIndex++)
+        {
+            int target = sampleIdOfVertex[edges[edgeIndex].to];
+            if (target >= 0)
+            {
+                sample.AddEdge(sampleId, target, edges[edgeIndex].weight);
+            }
+        }
+    }
+    return sample;
+}
+
+// Times every candidate on a BFS sample of the graph and keeps the fastest. The profile-based
+// choice is always a candidate, so calibration can only replace it with something that measured
+// faster. Heap stats recorded during calibration are discarded.
+template <typename GraphType>
+static HeapSelection CalibrateHeapSelection(const GraphType& graph, int startVertex, AutoHeapAlgorithm algorithm,
+                                            const HeapSelection& profileSelection)
+{
+    auto calibrationStart = std::chrono::steady_clock::now();
+
+    PairingHeapStats savedPairingStats = GetPairingHeapStats();
+    FibonacciHeapStats savedFibonacciStats = GetFibonacciHeapStats();
+    BucketQueueStats savedBucketStats = GetBucketQueueStats();
+
+    int sampleVertices = std::min(std::max(graph.Count() / CALIBRATION_SAMPLE_FRACTION, CALIBRATION_MIN_SAMPLE),
+                                  CALIBRATION_MAX_SAMPLE);
+    Graph sample = SampleSubgraph(graph, startVertex, sampleVertices);
+
+    auto sameHeap = [](const HeapSelection& a, const HeapSelection& b)
+    {
+        return a.kind == b.kind && (a.kind != HeapKind::Pairing || a.pairingStrategy == b.pairingStrategy);
+    };
+
+    std::vector<HeapSelection> candidates;
+    candidates.push_back(profileSelection);
+
+    const PairingHeapMergeStrategy pairingStrategies[] = {
+        PairingHeapMergeStrategy::TwoPass,
+        PairingHeapMergeStrategy::Multipass,
+        PairingHeapMergeStrategy::Lazy
+    };
+    for (PairingHeapMergeStrategy strategy : pairingStrategies)
+    {
+        HeapSelection candidate = profileSelection;
+        candidate.kind = HeapKind::Pairing;
+        candidate.pairingStrategy = strategy;
+        if (!sameHeap(candidate, profileSelection))
+        {
+            candidates.push_back(candidate);
+        }
+    }
+
+    HeapSelection fibonacciCandidate = profileSelection;
+    fibonacciCandidate.kind = HeapKind::Fibonacci;
+    candidates.push_back(fibonacciCandidate);
+
+    HeapSelection best = profileSelection;
+    long long bestNs = std::numeric_limits<long long>::max();
+
+    for (const HeapSelection& candidate : candidates)
+    {
+        long long fastestNs = std::numeric_limits<long long>::max();
+        for (int round = 0; round < CALIBRATION_ROUNDS; round++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (algorithm == AutoHeapAlgorithm::Dijkstra)
+            {
+                DijkstraUsingHeapSelection(sample, 0, candidate);
+            }
+            else
+            {
+                PrimUsingHeapSelection(sample, 0, candidate);
+            }
+            auto end = std::chrono::steady_clock::now();
+            fastestNs = std::min(fastestNs, (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+
+        if (fastestNs < bestNs)
+        {
+            bestNs = fastestNs;
+            best = candidate;
+        }
+    }
+
+    pairingHeapStats = savedPairingStats;
+    fibonacciHeapStats = savedFibonacciStats;
+    bucketQueueStats = savedBucketStats;
+
+    if (!sameHeap(best, profileSelection))
+    {
+        best.reason = "fastest on the calibration sample";
+    }
+    best.calibrated = true;
+
+    auto calibrationEnd = std::chrono::steady_clock::now();
+    best.calibrationUs = std::chrono::duration_cast<std::chrono::microseconds>(calibrationEnd - calibrationStart).count();
+    return best;
+}
+
+template <typename GraphType>
+static HeapSelection SelectHeap(const GraphType& graph, int startVertex, AutoHeapAlgorithm algorithm, bool calibrate)
+{
+    HeapSelection selection = SelectHeapForProfile(ProfileGraph(graph));
+    if (calibrate && graph.Count() > 0)
+    {
+        selection = CalibrateHeapSelection(graph, startVertex, algorithm, selection);
+    }
+    return selection;
+}
+
+// One line for logs: the choice, the statistics it was based on, and why.
+static std::string DescribeHeapSelection(const HeapSelection& selection)
+{
+    const GraphProfile& profile = selection.profile;
+
+    std::ostringstream description;
+    description << HeapSelectionName(selection)
+                << " (V=" << profile.vertices
+                << " E=" << profile.edges
+                << " avg degree " << profile.averageDegree
+                << " max degree " << profile.maxDegree
+                << " weights [" << profile.minWeight << "," << profile.maxWeight << "]"
+                << "; " << selection.reason;
+    if (selection.calibrated)
+    {
+        description << "; calibrated in " << selection.calibrationUs << " us";
+    }
+    description << ")";
+    return description.str();
+}
+
+// Dijkstra and Prim on whatever queue SelectHeap picks for this graph. The profile reads cached
+// statistics and costs nothing; calibrate adds the sample runs above, which only pay off on
+// large graphs. Callers answering many queries on one graph
+// should call SelectHeap once and reuse the result with DijkstraUsingHeapSelection. The choice
+// is returned through selection.
+template <typename GraphType>
+static std::pair<std::vector<int>, std::vector<int>>
+DijkstraUsingAutoHeap(const GraphType& graph, int sourceVertex, bool calibrate = false, HeapSelection* selection = nullptr)
+{
+    HeapSelection chosen = SelectHeap(graph, sourceVertex, AutoHeapAlgorithm::Dijkstra, calibrate);
+    if (selection != nullptr)
+    {
+        *selection = chosen;
+    }
+    return DijkstraUsingHeapSelection(graph, sourceVertex, chosen);
+}
+
+template <typename GraphType>
+static std::pair<std::vector<int>, int>
+PrimUsingAutoHeap(const GraphType& graph, int startVertex, bool calibrate = false, HeapSelection* selection = nullptr)
+{
+    HeapSelection chosen = SelectHeap(graph, startVertex, AutoHeapAlgorithm::Prim, calibrate);
+    if (selection != nullptr)
+    {
+        *selection = chosen;
+    }
+    return PrimUsingHeapSelection(graph, startVertex, chosen);
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstring>
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below 2^SUB_BUCKET_BITS ns
+// get a bucket each; above that, every power of two is split into 2^SUB_BUCKET_BITS equal
+// buckets, so a reported percentile is within about 3% of the true value over the whole range.
+// Recording is a bit scan and an increment, and two histograms merge by adding their counts,
+// so per-thread histograms can be combined after the fact.
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+
+private:
+    long long counts[BUCKET_COUNT];
+    long long totalCount;
+    long long totalNs;
+    long long maxNs;
+
+    static int BucketIndex(long long valueNs)
+    {
+        unsigned long long value = (unsigned long long)std::max(0LL, valueNs);
+        if (value < (unsigned long long)SUB_BUCKET_COUNT)
+        {
+            return (int)value;
+        }
+
+#if defined(__GNUC__)
+        int highestBit = 63 - __builtin_clzll(value);
+#else
+        int highestBit = 0;
+        while ((value >> (highestBit + 1)) != 0)
+        {
+            highestBit++;
+        }
+#endif
+        int shift = highestBit - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKET_COUNT + (int)((value >> shift) - SUB_BUCKET_COUNT);
+    }
+
+    // Largest value that lands in bucket index.
+    static long long BucketUpperBound(int index)
+    {
+        if (index < SUB_BUCKET_COUNT)
+        {
+            return index;
+        }
+
+        int shift = index / SUB_BUCKET_COUNT - 1;
+        long long top = SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT;
+        return ((top + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        std::memset(counts, 0, sizeof(counts));
+        totalCount = 0;
+        totalNs = 0;
+        maxNs = 0;
+    }
+
+    void Record(long long valueNs)
+    {
+        counts[BucketIndex(valueNs)]++;
+        totalCount++;
+        totalNs += valueNs;
+        maxNs = std::max(maxNs, valueNs);
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (int index = 0; index < BUCKET_COUNT; index++)
+        {
+            counts[index] += other.counts[index];
+        }
+        totalCount += other.totalCount;
+        totalNs += other.totalNs;
+        maxNs = std::max(maxNs, other.maxNs);
+    }
+
+    long long Count() const
+    {
+        return totalCount;
+    }
+
+    long long TotalNs() const
+    {
+        return totalNs;
+    }
+
+    long long MaxNs() const
+    {
+        return maxNs;
+    }
+
+    // Smallest bucket bound with at least percentile% of the samples at or below it, capped at
+    // the exact maximum. Returns 0 for an empty histogram.
+    long long PercentileNs(double percentile) const
+    {
+        if (totalCount == 0)
+        {
+            return 0;
+        }
+
+        long long rank = (long long)((percentile / 100.0) * (double)totalCount + 0.5);
+        rank = std::min(totalCount, std::max(1LL, rank));
+
+        long long seen = 0;
+        for (int index = 0; index < BUCKET_COUNT; index++)
+        {
+            seen += counts[index];
+            if (seen >= rank)
+            {
+                return std::min(BucketUpperBound(index), maxNs);
+            }
+        }
+        return maxNs;
+    }
+};
+
+// Latency of each heap operation. Both heaps keep one of these per thread.
+struct HeapOperationStats
+{
+    LatencyHistogram insertLatency;
+    LatencyHistogram deleteMinLatency;
+    LatencyHistogram decreaseKeyLatency;
+
+    // StageDecreaseKey is timed into decreaseKeyLatency like DecreaseKey, so both modes pay the
+    // same clock reads; stagedDecreaseKeys says how many of those calls were staged. Each
+    // ApplyStagedDecreaseKeys call with work to do is one batch sample.
+    long long stagedDecreaseKeys = 0;
+    LatencyHistogram decreaseKeyBatchLatency;
+
+    void Merge(const HeapOperationStats& other)
+    {
+        insertLatency.Merge(other.insertLatency);
+        deleteMinLatency.Merge(other.deleteMinLatency);
+        decreaseKeyLatency.Merge(other.decreaseKeyLatency);
+        stagedDecreaseKeys += other.stagedDecreaseKeys;
+        decreaseKeyBatchLatency.Merge(other.decreaseKeyBatchLatency);
+    }
+};
@@ -0,0 +1,710 @@
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <atomic>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#include <unistd.h>
+#define MEMORY_ALLOCATION_HAS_LINUX_MM
+#endif
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#endif
+
+// Where large arrays (CSR graphs, heap node pools) get their memory from. Small requests and
+// platforms without the Linux memory-management calls always use plain malloc.
+//   HugePageMode::Transparent  2MB-aligned mmap plus madvise(MADV_HUGEPAGE)
+//   HugePageMode::Explicit     mmap(MAP_HUGETLB) from the reserved 2MB pool, falling back to
+//                              Transparent when the pool is empty or absent
+//   NumaPolicy::Interleave     pages spread round-robin over all online nodes (mbind)
+//   NumaPolicy::Bind           pages restricted to numaNode (mbind)
+// Any call the kernel refuses is counted in allocationCounters and the region is used as is.
+enum class HugePageMode
+{
+    None,
+    Transparent,
+    Explicit
+};
+
+enum class NumaPolicy
+{
+    Default,
+    Interleave,
+    Bind
+};
+
+struct AllocationPolicy
+{
+    HugePageMode hugePages;
+    NumaPolicy numa;
+    int numaNode;
+};
+
+struct AllocationStats
+{
+    long long regionsMapped;
+    long long bytesMapped;
+    long long hugeTlbFallbacks;
+    long long adviseFailures;
+    long long numaFailures;
+};
+
+static AllocationPolicy activeAllocationPolicy = {HugePageMode::None, NumaPolicy::Default, 0};
+
+// Heaps on worker threads allocate concurrently, so the live counters are atomic and
+// GetAllocationStats returns a plain snapshot.
+struct AllocationCounters
+{
+    std::atomic<long long> regionsMapped{0};
+    std::atomic<long long> bytesMapped{0};
+    std::atomic<long long> hugeTlbFallbacks{0};
+    std::atomic<long long> adviseFailures{0};
+    std::atomic<long long> numaFailures{0};
+};
+
+static AllocationCounters allocationCounters;
+
+static const size_t HUGE_PAGE_BYTES = 2u << 20;
+
+// Requests below this size are not worth a dedicated mapping.
+static const size_t MIN_MAPPED_REGION_BYTES = 1u << 20;
+
+static void SetAllocationPolicy(const AllocationPolicy& policy)
+{
+    activeAllocationPolicy = policy;
+}
+
+static void ResetAllocationStats()
+{
+    allocationCounters.regionsMapped = 0;
+    allocationCounters.bytesMapped = 0;
+    allocationCounters.hugeTlbFallbacks = 0;
+    allocationCounters.adviseFailures = 0;
+    allocationCounters.numaFailures = 0;
+}
+
+static AllocationStats GetAllocationStats()
+{
+    return {allocationCounters.regionsMapped.load(), allocationCounters.bytesMapped.load(),
+            allocationCounters.hugeTlbFallbacks.load(), allocationCounters.adviseFailures.load(),
+            allocationCounters.numaFailures.load()};
+}
+
+static std::string AllocationPolicyName(const AllocationPolicy& policy)
+{
+    std::string name;
+    switch (policy.hugePages)
+    {
+        case HugePageMode::None:
+            name = "default";
+            break;
+        case HugePageMode::Transparent:
+            name = "thp";
+            break;
+        case HugePageMode::Explicit:
+            name = "hugetlb";
+            break;
+    }
+
+    if (policy.numa == NumaPolicy::Interleave)
+    {
+        name += ":interleave";
+    }
+    else if (policy.numa == NumaPolicy::Bind)
+    {
+        name += ":bind=" + std::to_string(policy.numaNode);
+    }
+    return name;
+}
+
+// Parses "<pages>[:interleave|:bind=<node>]" with pages one of default, thp, hugetlb.
+static bool ParseAllocationPolicy(const std::string& text, AllocationPolicy& policy)
+{
+    AllocationPolicy parsed = {HugePageMode::None, NumaPolicy::Default, 0};
+
+    size_t colon = text.find(':');
+    std::string pages = text.substr(0, colon);
+    std::string numa = (colon == std::string::npos) ? "" : text.substr(colon + 1);
+
+    if (pages == "default")
+    {
+        parsed.hugePages = HugePageMode::None;
+    }
+    else if (pages == "thp")
+    {
+        parsed.hugePages = HugePageMode::Transparent;
+    }
+    else if (pages == "hugetlb")
+    {
+        parsed.hugePages = HugePageMode::Explicit;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (numa == "interleave")
+    {
+        parsed.numa = NumaPolicy::Interleave;
+    }
+    else if (numa.compare(0, 5, "bind=") == 0 && numa.size() > 5)
+    {
+        parsed.numa = NumaPolicy::Bind;
+        parsed.numaNode = std::atoi(numa.c_str() + 5);
+    }
+    else if (!numa.empty())
+    {
+        return false;
+    }
+
+    policy = parsed;
+    return true;
+}
+
+// Highest online NUMA node id, from /sys ("0", "0-1", "0,2-3", ...); 0 if unknown.
+static int HighestOnlineNumaNode()
+{
+    std::ifstream in("/sys/devices/system/node/online");
+    std::string ranges;
+    if (!(in >> ranges))
+    {
+        return 0;
+    }
+
+    size_t lastNumber = ranges.find_last_of(",-");
+    return std::atoi(ranges.c_str() + ((lastNumber == std::string::npos) ? 0 : lastNumber + 1));
+}
+
+// AnonHugePages of this process from /proc/self/smaps_rollup, i.e. how much anonymous memory
+// the kernel actually backs with transparent huge pages; -1 where that file does not exist.
+static long long AnonHugePageBytes()
+{
+    std::ifstream in("/proc/self/smaps_rollup");
+    std::string field;
+    long long kilobytes = 0;
+    while (in >> field)
+    {
+        if (field == "AnonHugePages:")
+        {
+            in >> kilobytes;
+            return kilobytes * 1024;
+        }
+    }
+    return -1;
+}
+
+// A block of memory from AllocateRegion. mapped tells ReleaseRegion whether it came from mmap.
+struct MemoryRegion
+{
+    void* base;
+    size_t bytes;
+    bool mapped;
+};
+
+#ifdef MEMORY_ALLOCATION_HAS_LINUX_MM
+
+static void ApplyNumaPolicy(void* base, size_t bytes, const AllocationPolicy& policy)
+{
+    // Values of MPOL_BIND and MPOL_INTERLEAVE from <linux/mempolicy.h>; called through
+    // syscall so there is no libnuma dependency.
+    const int MPOL_BIND_MODE = 2;
+    const int MPOL_INTERLEAVE_MODE = 3;
+
+    unsigned long nodeMask = 0;
+    int mode = 0;
+    if (policy.numa == NumaPolicy::Interleave)
+    {
+        int highestNode = std::min(HighestOnlineNumaNode(), 63);
+        nodeMask = (highestNode >= 63) ? ~0UL : ((1UL << (highestNode + 1)) - 1);
+        mode = MPOL_INTERLEAVE_MODE;
+    }
+    else
+    {
+        if (policy.numaNode < 0 || policy.numaNode > 63)
+        {
+            allocationCounters.numaFailures++;
+            return;
+        }
+        nodeMask = 1UL << policy.numaNode;
+        mode = MPOL_BIND_MODE;
+    }
+
+    if (syscall(SYS_mbind, base, bytes, mode, &nodeMask, 64UL, 0U) != 0)
+    {
+        allocationCounters.numaFailures++;
+    }
+}
+
+// Anonymous mapping of at least bytes, aligned to alignment (a power of two multiple of the
+// page size) by over-mapping and trimming the ends.
+static void* MapAligned(size_t bytes, size_t alignment)
+{
+    size_t paddedBytes = bytes + alignment;
+    void* raw = mmap(nullptr, paddedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    uintptr_t start = (uintptr_t)raw;
+    uintptr_t alignedStart = (start + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    size_t headBytes = alignedStart - start;
+    size_t tailBytes = paddedBytes - headBytes - bytes;
+
+    if (headBytes > 0)
+    {
+        munmap(raw, headBytes);
+    }
+    if (tailBytes > 0)
+    {
+        munmap((void*)(alignedStart + bytes), tailBytes);
+    }
+    return (void*)alignedStart;
+}
+
+#endif
+
+// Allocates bytes according to activeAllocationPolicy. Never returns null: every fallback ends
+// in malloc, and a failing malloc throws std::bad_alloc.
+static MemoryRegion AllocateRegion(size_t bytes)
+{
+    const AllocationPolicy& policy = activeAllocationPolicy;
+    bool wantsMapping = policy.hugePages != HugePageMode::None || policy.numa != NumaPolicy::Default;
+
+#ifdef MEMORY_ALLOCATION_HAS_LINUX_MM
+    if (wantsMapping && bytes >= MIN_MAPPED_REGION_BYTES)
+    {
+        size_t roundedBytes = (bytes + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+        void* base = nullptr;
+
+        if (policy.hugePages == HugePageMode::Explicit)
+        {
+            base = mmap(nullptr, roundedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (base == MAP_FAILED)
+            {
+                base = nullptr;
+                allocationCounters.hugeTlbFallbacks++;
+            }
+        }
+
+        bool explicitHugePages = base != nullptr;
+        if (base == nullptr)
+        {
+            base = MapAligned(roundedBytes, HUGE_PAGE_BYTES);
+        }
+
+        if (base != nullptr)
+        {
+            if (!explicitHugePages && policy.hugePages != HugePageMode::None &&
+                madvise(base, roundedBytes, MADV_HUGEPAGE) != 0)
+            {
+                allocationCounters.adviseFailures++;
+            }
+
+            // The policy has to be in place before the first touch, which decides placement.
+            if (policy.numa != NumaPolicy::Default)
+            {
+                ApplyNumaPolicy(base, roundedBytes, policy);
+            }
+
+            allocationCounters.regionsMapped++;
+            allocationCounters.bytesMapped += (long long)roundedBytes;
+            return {base, roundedBytes, true};
+        }
+    }
+#else
+    (void)wantsMapping;
+#endif
+
+    void* base = std::malloc(bytes == 0 ? 1 : bytes);
+    if (base == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return {base, bytes, false};
+}
+
+static void ReleaseRegion(const MemoryRegion& region)
+{
+    if (region.base == nullptr)
+    {
+        return;
+    }
+
+#ifdef MEMORY_ALLOCATION_HAS_LINUX_MM
+    if (region.mapped)
+    {
+        munmap(region.base, region.bytes);
+        return;
+    }
+#endif
+    std::free(region.base);
+}
+
+// Fixed-size array in a region from AllocateRegion, for trivially copyable element types
+// (Edge, int, long long). Elements are left uninitialized, so the first write to each page is
+// also the one that places it under the NUMA policy.
+template <typename T>
+class RegionArray
+{
+private:
+    MemoryRegion region;
+    size_t count;
+
+public:
+    RegionArray() : region{nullptr, 0, false}, count(0) {}
+
+    explicit RegionArray(size_t count) : region(AllocateRegion(count * sizeof(T))), count(count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "RegionArray holds plain data only");
+    }
+
+    RegionArray(const RegionArray&) = delete;
+    RegionArray& operator=(const RegionArray&) = delete;
+
+    RegionArray(RegionArray&& other) : region(other.region), count(other.count)
+    {
+        other.region = {nullptr, 0, false};
+        other.count = 0;
+    }
+
+    RegionArray& operator=(RegionArray&& other)
+    {
+        if (this != &other)
+        {
+            ReleaseRegion(region);
+            region = other.region;
+            count = other.count;
+            other.region = {nullptr, 0, false};
+            other.count = 0;
+        }
+        return *this;
+    }
+
+    ~RegionArray()
+    {
+        ReleaseRegion(region);
+    }
+
+    T* Data()
+    {
+        return static_cast<T*>(region.base);
+    }
+
+    const T* Data() const
+    {
+        return static_cast<const T*>(region.base);
+    }
+
+    T& operator[](size_t index)
+    {
+        return Data()[index];
+    }
+
+    const T& operator[](size_t index) const
+    {
+        return Data()[index];
+    }
+
+    size_t Size() const
+    {
+        return count;
+    }
+
+    size_t Bytes() const
+    {
+        return count * sizeof(T);
+    }
+};
+
+// Free-list allocator for heap nodes. Nodes are carved out of chunks from AllocateRegion that
+// double in size up to MAX_CHUNK_NODES, so a large run touches a few big (huge-page backed)
+// regions instead of millions of separate mallocs, while a heap that only ever holds a few
+// nodes costs a few KB. Released nodes are reused before the next chunk is started; all chunks
+// are returned when the pool is destroyed.
+template <typename NodeType>
+class HeapNodePool
+{
+private:
+    static constexpr size_t FIRST_CHUNK_NODES = 64;
+    static constexpr size_t MAX_CHUNK_NODES = 1u << 20;
+
+    union Slot
+    {
+        Slot* nextFree;
+        alignas(NodeType) unsigned char storage[sizeof(NodeType)];
+    };
+
+    std::vector<MemoryRegion> chunks;
+    Slot* freeList;
+    Slot* freeTail;
+    Slot* chunkCursor;
+    Slot* chunkEnd;
+    size_t nextChunkNodes;
+
+public:
+    HeapNodePool() : freeList(nullptr), freeTail(nullptr), chunkCursor(nullptr), chunkEnd(nullptr), nextChunkNodes(FIRST_CHUNK_NODES) {}
+
+    HeapNodePool(const HeapNodePool&) = delete;
+    HeapNodePool& operator=(const HeapNodePool&) = delete;
+
+    ~HeapNodePool()
+    {
+        for (size_t index = 0; index < chunks.size(); index++)
+        {
+            ReleaseRegion(chunks[index]);
+        }
+    }
+
+    template <typename... Args>
+    NodeType* Allocate(Args&&... args)
+    {
+        Slot* slot = freeList;
+        if (slot != nullptr)
+        {
+            freeList = slot->nextFree;
+            if (freeList == nullptr)
+            {
+                freeTail = nullptr;
+            }
+        }
+        else
+        {
+            if (chunkCursor == chunkEnd)
+            {
+                MemoryRegion chunk = AllocateRegion(nextChunkNodes * sizeof(Slot));
+                chunks.push_back(chunk);
+                chunkCursor = static_cast<Slot*>(chunk.base);
+                chunkEnd = chunkCursor + nextChunkNodes;
+                nextChunkNodes = std::min(nextChunkNodes * 2, MAX_CHUNK_NODES);
+            }
+            slot = chunkCursor++;
+        }
+
+        return new (slot->storage) NodeType(std::forward<Args>(args)...);
+    }
+
+    void Release(NodeType* node)
+    {
+        node->~NodeType();
+        Slot* slot = reinterpret_cast<Slot*>(node);
+        slot->nextFree = freeList;
+        if (freeList == nullptr)
+        {
+            freeTail = slot;
+        }
+        freeList = slot;
+    }
+
+    // Frees every chunk at once, live nodes included, and starts over as a new pool. Like the
+    // destructor it runs no node destructors; heap nodes are plain data.
+    void Clear()
+    {
+        for (size_t index = 0; index < chunks.size(); index++)
+        {
+            ReleaseRegion(chunks[index]);
+        }
+        chunks.clear();
+        freeList = nullptr;
+        freeTail = nullptr;
+        chunkCursor = nullptr;
+        chunkEnd = nullptr;
+        nextChunkNodes = FIRST_CHUNK_NODES;
+    }
+
+    // Takes over the chunks and free slots of other, so nodes melded in from another heap stay
+    // valid for as long as this pool lives. Costs one step per chunk, not per node; the unused
+    // rest of other's current chunk is not reused.
+    void Adopt(HeapNodePool& other)
+    {
+        if (&other == this)
+        {
+            return;
+        }
+
+        chunks.insert(chunks.end(), other.chunks.begin(), other.chunks.end());
+        nextChunkNodes = std::max(nextChunkNodes, other.nextChunkNodes);
+
+        if (other.freeList != nullptr)
+        {
+            other.freeTail->nextFree = freeList;
+            if (freeList == nullptr)
+            {
+                freeTail = other.freeTail;
+            }
+            freeList = other.freeList;
+        }
+
+        other.chunks.clear();
+        other.freeList = nullptr;
+        other.freeTail = nullptr;
+        other.chunkCursor = nullptr;
+        other.chunkEnd = nullptr;
+    }
+};
+
+// Counts data-TLB load misses of the calling thread (user space only) with perf_event_open.
+// Available() is false when the kernel, a container or perf_event_paranoid does not allow it,
+// and Stop() then returns -1.
+class TlbMissCounter
+{
+private:
+    int descriptor;
+
+public:
+    TlbMissCounter() : descriptor(-1)
+    {
+#ifdef MEMORY_ALLOCATION_HAS_LINUX_MM
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        descriptor = (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+    }
+
+    TlbMissCounter(const TlbMissCounter&) = delete;
+    TlbMissCounter& operator=(const TlbMissCounter&) = delete;
+
+    ~TlbMissCounter()
+    {
+#ifdef MEMORY_ALLOCATION_HAS_LINUX_MM
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+#endif
+    }
+
+    bool Available() const
+    {
+        return descriptor >= 0;
+    }
+
+    void Start()
+    {
+#ifdef MEMORY_ALLOCATION_HAS_LINUX_MM
+        if (descriptor >= 0)
+        {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    long long Stop()
+    {
+#ifdef MEMORY_ALLOCATION_HAS_LINUX_MM
+        if (descriptor >= 0)
+        {
+            ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            long long count = 0;
+            if (read(descriptor, &count, sizeof(count)) == (ssize_t)sizeof(count))
+            {
+                return count;
+            }
+        }
+#endif
+        return -1;
+    }
+};
+
+// Adjacency in CSR form with both arrays in policy-allocated regions, so a large graph sits on
+// a handful of 2MB pages instead of one heap block per vertex. Same neighbor interface as Graph.
+class CsrGraph
+{
+public:
+    RegionArray<long long> offsets;
+    RegionArray<Edge> edges;
+    int maxDegree;
+    int minWeight;
+    int maxWeight;
+
+    static CsrGraph FromGraph(const Graph& graph);
+
+    int Count() const
+    {
+        return (int)offsets.Size() - 1;
+    }
+
+    int Degree(int u) const
+    {
+        return (int)(offsets[u + 1] - offsets[u]);
+    }
+
+    int MaxDegree() const
+    {
+        return maxDegree;
+    }
+
+    long long DirectedEdgeCount() const
+    {
+        return offsets[Count()];
+    }
+
+    // Copied from the source Graph, so these are bounds in the same sense as Graph's.
+    int MinEdgeWeight() const
+    {
+        return minWeight;
+    }
+
+    int MaxEdgeWeight() const
+    {
+        return maxWeight;
+    }
+
+    const Edge* NeighborEdges(int u, Edge* /*scratch*/) const
+    {
+        return edges.Data() + offsets[u];
+    }
+
+    long long AdjacencyBytes() const
+    {
+        return (long long)(offsets.Bytes() + edges.Bytes());
+    }
+};
+
+CsrGraph CsrGraph::FromGraph(const Graph& graph)
+{
+    CsrGraph csr;
+    csr.offsets = RegionArray<long long>((size_t)graph.Count() + 1);
+    csr.maxDegree = 0;
+    csr.minWeight = graph.MinEdgeWeight();
+    csr.maxWeight = graph.MaxEdgeWeight();
+
+    long long edgeCount = 0;
+    for (int u = 0; u < graph.Count(); u++)
+    {
+        csr.offsets[u] = edgeCount;
+        edgeCount += graph.Degree(u);
+        csr.maxDegree = std::max(csr.maxDegree, graph.Degree(u));
+    }
+    csr.offsets[graph.Count()] = edgeCount;
+
+    csr.edges = RegionArray<Edge>((size_t)edgeCount);
+    for (int u = 0; u < graph.Count(); u++)
+    {
+        std::memcpy(csr.edges.Data() + csr.offsets[u], graph.adj[u].data(), graph.adj[u].size() * sizeof(Edge));
+    }
+
+    return csr;
+}
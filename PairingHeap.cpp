@@ -1,21 +1,21 @@
+#include <vector>
 #include <stdexcept>
 #include <chrono>
 
-struct PairingHeapStats
-{
-    long long insertCount;
-    long long deleteMinCount;
-    long long decreaseKeyCount;
-    long long insertNs;
-    long long deleteMinNs;
-    long long decreaseKeyNs;
-};
+#ifndef UNITY_BUILD
+#include "LatencyHistogram.cpp"
+#include "MemoryAllocation.cpp"
+#include "Prefetch.cpp"
+#endif
+
+typedef HeapOperationStats PairingHeapStats;
 
-static PairingHeapStats pairingHeapStats = {0, 0, 0, 0, 0, 0};
+// Per thread, so heaps running on different worker threads do not share histograms.
+static thread_local PairingHeapStats pairingHeapStats;
 
 static void ResetPairingHeapStats()
 {
-    pairingHeapStats = {0, 0, 0, 0, 0, 0};
+    pairingHeapStats = PairingHeapStats();
 }
 
 static PairingHeapStats GetPairingHeapStats()
@@ -45,17 +45,56 @@ public:
     }
 };
 
+// How DeleteMin combines the children of the old root.
+// RecursiveTwoPass is the original implementation and is kept only as a benchmark baseline:
+// it recurses once per pair of siblings and overflows the stack on wide roots.
+// Lazy buffers inserts and decrease-keys in an auxiliary root list that is multipass-merged
+// on the next FindMin/DeleteMin, and uses TwoPass for the children of the deleted root.
+enum class PairingHeapMergeStrategy
+{
+    RecursiveTwoPass,
+    TwoPass,
+    Multipass,
+    FrontToBack,
+    Lazy
+};
+
+static const char* PairingHeapMergeStrategyName(PairingHeapMergeStrategy strategy)
+{
+    switch (strategy)
+    {
+        case PairingHeapMergeStrategy::RecursiveTwoPass:
+            return "pairing_recursive";
+        case PairingHeapMergeStrategy::TwoPass:
+            return "pairing";
+        case PairingHeapMergeStrategy::Multipass:
+            return "pairing_multipass";
+        case PairingHeapMergeStrategy::FrontToBack:
+            return "pairing_front_to_back";
+        case PairingHeapMergeStrategy::Lazy:
+            return "pairing_lazy";
+    }
+    return "pairing_unknown";
+}
+
 class PairingHeap
 {
 private:
     PairingHeapNode* root;
+    PairingHeapNode* auxiliaryHead;
+    PairingHeapNode* auxiliaryTail;
     int nodeCount;
+    PairingHeapMergeStrategy mergeStrategy;
+    HeapNodePool<PairingHeapNode> nodePool;
 
 public:
-    PairingHeap()
+    explicit PairingHeap(PairingHeapMergeStrategy strategy = PairingHeapMergeStrategy::TwoPass)
     {
         root = nullptr;
+        auxiliaryHead = nullptr;
+        auxiliaryTail = nullptr;
         nodeCount = 0;
+        mergeStrategy = strategy;
     }
 
     PairingHeapNode* Insert(int key, int vertexId);
@@ -64,30 +103,102 @@ public:
     void DecreaseKey(PairingHeapNode* node, int newKey);
     int Count();
 
+    // Batched decrease-key. StageDecreaseKey lowers the key and cuts the node from its parent
+    // into the auxiliary root list; ApplyStagedDecreaseKeys multipass-merges that list once and
+    // melds the result with the root. FindMin, DeleteMin and Meld apply pending stages of the
+    // heaps involved first. The lazy strategy keeps staged nodes in its auxiliary list like any
+    // other decrease-key, and merges them on the next FindMin or DeleteMin.
+    void StageDecreaseKey(PairingHeapNode* node, int newKey);
+    void ApplyStagedDecreaseKeys();
+
+    // Moves every node of other into this heap in O(1) and leaves other empty. Handles into
+    // other stay valid and now belong to this heap, which also takes over other's node storage.
+    void Meld(PairingHeap& other);
+
+    // Returns a node handed out by DeleteMin to the pool. Nodes are owned by the heap and the
+    // remaining ones are freed with it, so callers must not delete them.
+    void ReleaseNode(PairingHeapNode* node)
+    {
+        nodePool.Release(node);
+    }
+
+    // Drops every node still in the heap without timing or counting anything; handles into the
+    // heap become invalid. Cheaper than draining with DeleteMin when the rest is not needed.
+    void Clear()
+    {
+        root = nullptr;
+        auxiliaryHead = nullptr;
+        auxiliaryTail = nullptr;
+        nodeCount = 0;
+        nodePool.Clear();
+    }
+
+    // Calls visit on every node still in the heap, staged and buffered ones included, in no
+    // particular order and without timing or counting anything. visit must not change the heap.
+    template <typename Visitor>
+    void ForEachNode(Visitor visit) const
+    {
+        std::vector<PairingHeapNode*> pending;
+        if (root != nullptr)
+        {
+            pending.push_back(root);
+        }
+        for (PairingHeapNode* node = auxiliaryHead; node != nullptr; node = node->nextSibling)
+        {
+            pending.push_back(node);
+        }
+
+        while (!pending.empty())
+        {
+            PairingHeapNode* node = pending.back();
+            pending.pop_back();
+            visit(node);
+            for (PairingHeapNode* child = node->firstChild; child != nullptr; child = child->nextSibling)
+            {
+                pending.push_back(child);
+            }
+        }
+    }
+
 private:
     PairingHeapNode* Meld(PairingHeapNode* a, PairingHeapNode* b);
+    PairingHeapNode* MergeSiblingList(PairingHeapNode* firstSibling);
     PairingHeapNode* MergePairs(PairingHeapNode* firstSibling);
+    PairingHeapNode* TwoPassMerge(PairingHeapNode* firstSibling);
+    PairingHeapNode* MultipassMerge(PairingHeapNode* firstSibling);
+    PairingHeapNode* FrontToBackMerge(PairingHeapNode* firstSibling);
+    void PushAuxiliary(PairingHeapNode* node);
+    void FlushAuxiliaryList();
     void LinkChild(PairingHeapNode* parent, PairingHeapNode* child);
     void CutFromParent(PairingHeapNode* node);
+    void DetachNode(PairingHeapNode* node);
 };
 
 PairingHeapNode* PairingHeap::Insert(int key, int vertexId)
 {
     auto startTime = std::chrono::steady_clock::now();
 
-    PairingHeapNode* newNode = new PairingHeapNode(key, vertexId);
-    root = Meld(root, newNode);
+    PairingHeapNode* newNode = nodePool.Allocate(key, vertexId);
+    if (mergeStrategy == PairingHeapMergeStrategy::Lazy)
+    {
+        PushAuxiliary(newNode);
+    }
+    else
+    {
+        root = Meld(root, newNode);
+    }
     nodeCount++;
 
     auto endTime = std::chrono::steady_clock::now();
-    pairingHeapStats.insertCount = pairingHeapStats.insertCount + 1;
-    pairingHeapStats.insertNs = pairingHeapStats.insertNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    pairingHeapStats.insertLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
 
     return newNode;
 }
 
 PairingHeapNode* PairingHeap::FindMin()
 {
+    FlushAuxiliaryList();
+
     if (root == nullptr)
     {
         throw std::runtime_error("FindMin on empty heap");
@@ -99,6 +210,8 @@ PairingHeapNode* PairingHeap::DeleteMin()
 {
     auto startTime = std::chrono::steady_clock::now();
 
+    FlushAuxiliaryList();
+
     if (root == nullptr)
     {
         throw std::runtime_error("DeleteMin on empty heap");
@@ -112,7 +225,7 @@ PairingHeapNode* PairingHeap::DeleteMin()
     oldRoot->nextSibling = nullptr;
     oldRoot->prevSibling = nullptr;
 
-    root = MergePairs(childList);
+    root = MergeSiblingList(childList);
     nodeCount--;
 
     if (root != nullptr)
@@ -121,8 +234,7 @@ PairingHeapNode* PairingHeap::DeleteMin()
     }
 
     auto endTime = std::chrono::steady_clock::now();
-    pairingHeapStats.deleteMinCount = pairingHeapStats.deleteMinCount + 1;
-    pairingHeapStats.deleteMinNs = pairingHeapStats.deleteMinNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    pairingHeapStats.deleteMinLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
 
     return oldRoot;
 }
@@ -138,15 +250,61 @@ void PairingHeap::DecreaseKey(PairingHeapNode* node, int newKey)
 
     node->priorityKey = newKey;
 
-    if (node != root)
+    if (mergeStrategy == PairingHeapMergeStrategy::Lazy)
     {
+        if (node != root && node->parent != nullptr)
+        {
+            CutFromParent(node);
+            PushAuxiliary(node);
+        }
+    }
+    else if (node != root && node->parent != nullptr)
+    {
+        // A non-root node without a parent is staged in the auxiliary list and stays there.
         CutFromParent(node);
         root = Meld(root, node);
     }
 
     auto endTime = std::chrono::steady_clock::now();
-    pairingHeapStats.decreaseKeyCount = pairingHeapStats.decreaseKeyCount + 1;
-    pairingHeapStats.decreaseKeyNs = pairingHeapStats.decreaseKeyNs + std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    pairingHeapStats.decreaseKeyLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+}
+
+void PairingHeap::StageDecreaseKey(PairingHeapNode* node, int newKey)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    if (newKey >= node->priorityKey)
+    {
+        throw std::runtime_error("New key is not smaller than current key in StageDecreaseKey");
+    }
+
+    node->priorityKey = newKey;
+
+    if (node != root && node->parent != nullptr)
+    {
+        CutFromParent(node);
+        PushAuxiliary(node);
+    }
+    pairingHeapStats.stagedDecreaseKeys++;
+
+    auto endTime = std::chrono::steady_clock::now();
+    pairingHeapStats.decreaseKeyLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+}
+
+void PairingHeap::ApplyStagedDecreaseKeys()
+{
+    // The lazy strategy keeps its auxiliary list until the next FindMin/DeleteMin anyway.
+    if (auxiliaryHead == nullptr || mergeStrategy == PairingHeapMergeStrategy::Lazy)
+    {
+        return;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    FlushAuxiliaryList();
+
+    auto endTime = std::chrono::steady_clock::now();
+    pairingHeapStats.decreaseKeyBatchLatency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
 }
 
 int PairingHeap::Count()
@@ -154,6 +312,52 @@ int PairingHeap::Count()
     return nodeCount;
 }
 
+void PairingHeap::Meld(PairingHeap& other)
+{
+    if (&other == this)
+    {
+        return;
+    }
+
+    if (mergeStrategy == PairingHeapMergeStrategy::Lazy)
+    {
+        // Both auxiliary lists are spliced and other's root joins them, so nothing is compared
+        // until the next FindMin/DeleteMin.
+        if (other.auxiliaryHead != nullptr)
+        {
+            if (auxiliaryHead == nullptr)
+            {
+                auxiliaryHead = other.auxiliaryHead;
+            }
+            else
+            {
+                auxiliaryTail->nextSibling = other.auxiliaryHead;
+                other.auxiliaryHead->prevSibling = auxiliaryTail;
+            }
+            auxiliaryTail = other.auxiliaryTail;
+        }
+        if (other.root != nullptr)
+        {
+            PushAuxiliary(other.root);
+        }
+    }
+    else
+    {
+        // Staged nodes of both heaps, and the buffered nodes of a lazy other, are merged first.
+        ApplyStagedDecreaseKeys();
+        other.FlushAuxiliaryList();
+        root = Meld(root, other.root);
+    }
+
+    nodeCount += other.nodeCount;
+    nodePool.Adopt(other.nodePool);
+
+    other.root = nullptr;
+    other.auxiliaryHead = nullptr;
+    other.auxiliaryTail = nullptr;
+    other.nodeCount = 0;
+}
+
 PairingHeapNode* PairingHeap::Meld(PairingHeapNode* a, PairingHeapNode* b)
 {
     if (a == nullptr)
@@ -247,6 +451,7 @@ PairingHeapNode* PairingHeap::MergePairs(PairingHeapNode* firstSibling)
     if (remainingSiblings != nullptr)
     {
         remainingSiblings->prevSibling = nullptr;
+        PQ_PREFETCH(remainingSiblings->nextSibling);
     }
 
     PairingHeapNode* mergedPair = Meld(first, second);
@@ -254,3 +459,178 @@ PairingHeapNode* PairingHeap::MergePairs(PairingHeapNode* firstSibling)
 
     return Meld(mergedPair, mergedRest);
 }
+
+PairingHeapNode* PairingHeap::MergeSiblingList(PairingHeapNode* firstSibling)
+{
+    switch (mergeStrategy)
+    {
+        case PairingHeapMergeStrategy::RecursiveTwoPass:
+            return MergePairs(firstSibling);
+        case PairingHeapMergeStrategy::Multipass:
+            return MultipassMerge(firstSibling);
+        case PairingHeapMergeStrategy::FrontToBack:
+            return FrontToBackMerge(firstSibling);
+        case PairingHeapMergeStrategy::TwoPass:
+        case PairingHeapMergeStrategy::Lazy:
+            break;
+    }
+    return TwoPassMerge(firstSibling);
+}
+
+void PairingHeap::DetachNode(PairingHeapNode* node)
+{
+    node->parent = nullptr;
+    node->prevSibling = nullptr;
+    node->nextSibling = nullptr;
+}
+
+PairingHeapNode* PairingHeap::TwoPassMerge(PairingHeapNode* firstSibling)
+{
+    if (firstSibling == nullptr)
+    {
+        return nullptr;
+    }
+
+    // First pass: meld adjacent pairs left to right. The winners are pushed onto a stack
+    // threaded through nextSibling, so the second pass sees them right to left.
+    PairingHeapNode* pairStack = nullptr;
+    PairingHeapNode* current = firstSibling;
+
+    while (current != nullptr)
+    {
+        PairingHeapNode* first = current;
+        PairingHeapNode* second = first->nextSibling;
+        current = (second != nullptr) ? second->nextSibling : nullptr;
+
+        // The next pair starts two hops down the list; start loading it while this one is melded.
+        PQ_PREFETCH_WRITE(current);
+
+        DetachNode(first);
+        PairingHeapNode* mergedPair = first;
+
+        if (second != nullptr)
+        {
+            DetachNode(second);
+            mergedPair = Meld(first, second);
+        }
+
+        mergedPair->nextSibling = pairStack;
+        pairStack = mergedPair;
+    }
+
+    // Second pass: fold the pairs from the rightmost one back to the first.
+    PairingHeapNode* result = pairStack;
+    pairStack = pairStack->nextSibling;
+    result->nextSibling = nullptr;
+
+    while (pairStack != nullptr)
+    {
+        PairingHeapNode* next = pairStack->nextSibling;
+        PQ_PREFETCH_WRITE(next);
+        pairStack->nextSibling = nullptr;
+        result = Meld(pairStack, result);
+        pairStack = next;
+    }
+
+    return result;
+}
+
+PairingHeapNode* PairingHeap::MultipassMerge(PairingHeapNode* firstSibling)
+{
+    if (firstSibling == nullptr)
+    {
+        return nullptr;
+    }
+
+    // The sibling list doubles as a FIFO queue: meld the two front trees and append the winner.
+    PairingHeapNode* head = firstSibling;
+    PairingHeapNode* tail = firstSibling;
+
+    for (PairingHeapNode* node = firstSibling; node != nullptr; node = node->nextSibling)
+    {
+        PQ_PREFETCH_WRITE(node->nextSibling);
+        node->parent = nullptr;
+        node->prevSibling = nullptr;
+        tail = node;
+    }
+
+    while (head->nextSibling != nullptr)
+    {
+        PairingHeapNode* first = head;
+        PairingHeapNode* second = first->nextSibling;
+        head = second->nextSibling;
+
+        PQ_PREFETCH_WRITE(head);
+
+        first->nextSibling = nullptr;
+        second->nextSibling = nullptr;
+
+        PairingHeapNode* mergedPair = Meld(first, second);
+
+        if (head == nullptr)
+        {
+            head = mergedPair;
+        }
+        else
+        {
+            tail->nextSibling = mergedPair;
+        }
+        tail = mergedPair;
+    }
+
+    return head;
+}
+
+PairingHeapNode* PairingHeap::FrontToBackMerge(PairingHeapNode* firstSibling)
+{
+    if (firstSibling == nullptr)
+    {
+        return nullptr;
+    }
+
+    PairingHeapNode* current = firstSibling->nextSibling;
+    DetachNode(firstSibling);
+    PairingHeapNode* result = firstSibling;
+
+    while (current != nullptr)
+    {
+        PairingHeapNode* next = current->nextSibling;
+        PQ_PREFETCH_WRITE(next);
+        DetachNode(current);
+        result = Meld(result, current);
+        current = next;
+    }
+
+    return result;
+}
+
+void PairingHeap::PushAuxiliary(PairingHeapNode* node)
+{
+    node->parent = nullptr;
+    node->prevSibling = nullptr;
+    node->nextSibling = auxiliaryHead;
+
+    if (auxiliaryHead != nullptr)
+    {
+        auxiliaryHead->prevSibling = node;
+    }
+    else
+    {
+        auxiliaryTail = node;
+    }
+
+    auxiliaryHead = node;
+}
+
+void PairingHeap::FlushAuxiliaryList()
+{
+    if (auxiliaryHead == nullptr)
+    {
+        return;
+    }
+
+    PairingHeapNode* combined = MultipassMerge(auxiliaryHead);
+    auxiliaryHead = nullptr;
+    auxiliaryTail = nullptr;
+    root = Meld(root, combined);
+}
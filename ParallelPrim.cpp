@@ -0,0 +1,654 @@
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#include "PairingHeap.cpp"
+#include "FibonacciHeap.cpp"
+#include "CompressedGraph.cpp"
+#include "Relaxation.cpp"
+#endif
+
+// Shape of the last ParallelPrim run: how many Prim trees phase 1 started, how many Boruvka
+// rounds phase 2 needed, and how many trees both phases absorbed into another (folded into its
+// heap in phase 1, melded in phase 2).
+struct ParallelPrimStats
+{
+    int treeCount;
+    int boruvkaRounds;
+    int meldCount;
+};
+
+static ParallelPrimStats parallelPrimStats = {0, 0, 0};
+
+static ParallelPrimStats GetParallelPrimStats()
+{
+    return parallelPrimStats;
+}
+
+// Component id of tree after following union-find links, without path compression, so several
+// threads can look components up at once while no union is in progress.
+static int FindTreeComponent(const std::vector<int>& componentLink, int tree)
+{
+    while (componentLink[tree] != tree)
+    {
+        tree = componentLink[tree];
+    }
+    return tree;
+}
+
+// Multi-tree Prim in the style of Boruvka. A tree's heap holds one entry per frontier vertex,
+// keyed by the weight of the lightest known edge into it as in PrimImplementation, plus one
+// entry per neighboring tree for the lightest known edge into any of its vertices. vertexId
+// holds the global id of that edge (its position in the concatenated neighbor lists, so the
+// graph must have fewer than 2^31 directed edges) and is rewritten on every DecreaseKey, so an
+// entry still names both endpoints after it changes hands. Edges are filtered with
+// findImprovedEdges against a per-thread key array, and edges into the tree or into trees it has
+// absorbed never enter the heap.
+//
+// Phase 1: threadCount threads take seeds from a shuffled vertex order and grow a Prim tree
+// from each seed they can claim, one heap per tree. Vertices are claimed with a compare-and-swap
+// on their owner, so every vertex ends up in exactly one tree. When the lightest edge leaving a
+// tree leads into a tree that has stopped ("parked"), the two are contracted: the entries of the
+// parked heap are folded into this tree's frontier, which drops the ones that are internal or
+// beaten by a lighter entry, and growth continues from the union. When it leads into a tree that
+// is still growing, the tree with the higher id waits for the other one to park, and the one with
+// the lower id parks itself and waits to be absorbed. At most threadCount trees are growing or
+// parked at once. Every edge taken is the lightest edge leaving its component, so all of them
+// belong to a minimum spanning forest.
+//
+// Phase 2: Boruvka rounds over the components still parked at the end. Each drops the internal
+// edges at the top of its heap to find its lightest outgoing edge (the components are split
+// over the threads), and then the chosen edges are applied one by one: union-find joins the two
+// components, skipping edges that would close a cycle, and the heaps are melded.
+//
+// Returns the same as PrimImplementation: parents of the spanning tree of the component of
+// startVertex (found by BFS over the chosen edges, -1 outside it) and its total weight.
+template <typename HeapType, typename HeapNodeType, typename GraphType, typename HeapFactory>
+static std::pair<std::vector<int>, int>
+ParallelPrimImplementation(const GraphType& graph, int startVertex, int threadCount, HeapFactory makeHeap)
+{
+    const int UNCLAIMED = -1;
+    const int NOT_SEEN = std::numeric_limits<int>::max();
+    const int IN_TREE = std::numeric_limits<int>::min();
+    RelaxationKernel findImprovedEdges = activeRelaxationKernel;
+
+    int numberOfVertices = graph.Count();
+    threadCount = std::max(1, threadCount);
+
+    // Global edge ids: the edges of u are edgeOffsets[u] .. edgeOffsets[u + 1] - 1.
+    std::vector<long long> edgeOffsets(numberOfVertices + 1, 0);
+    for (int u = 0; u < numberOfVertices; u++)
+    {
+        edgeOffsets[u + 1] = edgeOffsets[u] + graph.Degree(u);
+    }
+
+    // Edge ids travel in the int vertexId field of the heap nodes.
+    if (edgeOffsets[numberOfVertices] > (long long)std::numeric_limits<int>::max())
+    {
+        throw std::runtime_error("ParallelPrim needs fewer than 2^31 directed edges");
+    }
+
+    // One pass over every edge, so it is split over the threads by vertex range.
+    std::vector<int> edgeTarget(edgeOffsets[numberOfVertices]);
+    auto fillEdgeTargets = [&](int threadIndex) {
+        int firstVertex = (int)((long long)numberOfVertices * threadIndex / threadCount);
+        int lastVertex = (int)((long long)numberOfVertices * (threadIndex + 1) / threadCount);
+        std::vector<Edge> decodedEdges(graph.MaxDegree(), Edge(0, 0));
+        for (int u = firstVertex; u < lastVertex; u++)
+        {
+            const Edge* edges = graph.NeighborEdges(u, decodedEdges.data());
+            for (int edgeIndex = 0; edgeIndex < graph.Degree(u); edgeIndex++)
+            {
+                edgeTarget[edgeOffsets[u] + edgeIndex] = edges[edgeIndex].to;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int threadIndex = 1; threadIndex < threadCount; threadIndex++)
+    {
+        workers.emplace_back(fillEdgeTargets, threadIndex);
+    }
+    fillEdgeTargets(0);
+    for (int threadIndex = 0; threadIndex < (int)workers.size(); threadIndex++)
+    {
+        workers[threadIndex].join();
+    }
+    workers.clear();
+
+    // Sources are only needed for the few edges that end up in the forest.
+    auto edgeSource = [&](int edgeId) {
+        return (int)(std::upper_bound(edgeOffsets.begin(), edgeOffsets.end(), (long long)edgeId) - edgeOffsets.begin()) - 1;
+    };
+
+    std::vector<std::atomic<int>> owner(numberOfVertices);
+    for (int v = 0; v < numberOfVertices; v++)
+    {
+        owner[v].store(UNCLAIMED, std::memory_order_relaxed);
+    }
+
+    std::vector<int> seedOrder(numberOfVertices);
+    for (int v = 0; v < numberOfVertices; v++)
+    {
+        seedOrder[v] = v;
+    }
+    std::shuffle(seedOrder.begin(), seedOrder.end(), std::mt19937(12345));
+
+    // Trees are identified by the id they got when their seed was claimed, and owner[v] keeps
+    // that id. componentLink is a union-find over tree ids (an id is never larger than the
+    // number of seeds tried, so V slots suffice); in phase 1 it, parked, heaps and the tree
+    // counts below are only touched under forestMutex, and forestChanged is signalled whenever
+    // a tree parks or is absorbed.
+    std::vector<int> componentLink(numberOfVertices);
+    for (int tree = 0; tree < numberOfVertices; tree++)
+    {
+        componentLink[tree] = tree;
+    }
+    std::vector<std::unique_ptr<HeapType>> heaps(numberOfVertices);
+    std::vector<bool> parked(numberOfVertices, false);
+    std::mutex forestMutex;
+    std::condition_variable forestChanged;
+
+    // Live trees are growing, or parked until a growing tree absorbs them. At most threadCount
+    // are live at once: a thread whose tree parked waits for an absorption before it seeds
+    // another one, instead of piling up small trees whose frontiers turn into stale entries
+    // once they are melded. The cap is lifted when no tree is growing, so it cannot deadlock.
+    int liveTrees = 0;
+    int growingTrees = 0;
+
+    auto findComponent = [&](int tree) {
+        int component = FindTreeComponent(componentLink, tree);
+        while (componentLink[tree] != component)
+        {
+            int next = componentLink[tree];
+            componentLink[tree] = component;
+            tree = next;
+        }
+        return component;
+    };
+
+    std::atomic<int> nextSeed(0);
+    std::atomic<int> nextTreeId(0);
+    std::atomic<int> grownTreeCount(0);
+    std::atomic<int> phaseOneMeldCount(0);
+
+    // Per thread: the edges it took.
+    std::vector<std::vector<int>> threadForestEdges(threadCount);
+
+    auto growTrees = [&](int threadIndex) {
+        std::vector<Edge> decodedEdges(graph.MaxDegree(), Edge(0, 0));
+        std::vector<int> improvedEdgeIndices(graph.MaxDegree());
+
+        // Key of every vertex the current tree has seen, laid out for findImprovedEdges as in
+        // PrimImplementation: IN_TREE for vertices known to be in the tree, so the kernel skips
+        // edges back into it, and otherwise the lightest edge seen into the vertex.
+        std::vector<int> vertexKey(numberOfVertices, NOT_SEEN);
+        std::vector<int> touchedVertices;
+
+        // Frontier handles of the current tree: slot v for an unclaimed vertex v, and slot
+        // numberOfVertices + t for the lightest known edge into tree t, whose key is treeKey[t].
+        // Edges into a claimed vertex share its tree's entry, so a dense neighborhood of another
+        // tree costs one heap entry instead of one per vertex.
+        std::vector<HeapNodeType*> frontierHandle(2 * (size_t)numberOfVertices, nullptr);
+        std::vector<int> treeKey(numberOfVertices, 0);
+        std::vector<int> frontierTrees;
+
+        // absorbedInto[t] is the id of this thread's tree that t is known to be part of. Edges
+        // into such trees are internal: they are skipped when scanned and dropped without taking
+        // forestMutex when they reach the top of the heap.
+        std::vector<int> absorbedInto(numberOfVertices, UNCLAIMED);
+        std::vector<int>& forestEdges = threadForestEdges[threadIndex];
+
+        // A seed whose lightest edge already leads into another tree would park right away
+        // with its whole neighbor list as heap entries. Such seeds are put off until the shared
+        // seed order is used up; by then most are claimed by a growing tree, and the rest find
+        // parked trees to absorb.
+        std::vector<int> deferredSeeds;
+        int deferredIndex = 0;
+
+        while (true)
+        {
+            int seed;
+            int seedIndex = nextSeed.fetch_add(1);
+            if (seedIndex < numberOfVertices)
+            {
+                seed = seedOrder[seedIndex];
+            }
+            else if (deferredIndex < (int)deferredSeeds.size())
+            {
+                seed = deferredSeeds[deferredIndex++];
+            }
+            else
+            {
+                break;
+            }
+
+            if (owner[seed].load(std::memory_order_relaxed) != UNCLAIMED)
+            {
+                continue;
+            }
+
+            if (seedIndex < numberOfVertices && graph.Degree(seed) > 0)
+            {
+                const Edge* seedEdges = graph.NeighborEdges(seed, decodedEdges.data());
+                int lightestEdgeIndex = 0;
+                for (int edgeIndex = 1; edgeIndex < graph.Degree(seed); edgeIndex++)
+                {
+                    if (seedEdges[edgeIndex].weight < seedEdges[lightestEdgeIndex].weight)
+                    {
+                        lightestEdgeIndex = edgeIndex;
+                    }
+                }
+                if (owner[seedEdges[lightestEdgeIndex].to].load(std::memory_order_relaxed) != UNCLAIMED)
+                {
+                    deferredSeeds.push_back(seed);
+                    continue;
+                }
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(forestMutex);
+                forestChanged.wait(lock, [&]() { return liveTrees < threadCount || growingTrees == 0; });
+                liveTrees++;
+                growingTrees++;
+            }
+
+            int treeId = nextTreeId.fetch_add(1);
+            int expected = UNCLAIMED;
+            if (!owner[seed].compare_exchange_strong(expected, treeId))
+            {
+                std::lock_guard<std::mutex> lock(forestMutex);
+                liveTrees--;
+                growingTrees--;
+                forestChanged.notify_all();
+                continue;
+            }
+            grownTreeCount++;
+
+            std::unique_ptr<HeapType> heap(makeHeap());
+            int claimedVertex = seed;
+            vertexKey[seed] = IN_TREE;
+            touchedVertices.push_back(seed);
+
+            // Makes an edge of the given weight into neighborVertex a frontier entry of this
+            // tree, unless it is internal or a lighter entry already covers its endpoint.
+            auto addFrontierEdge = [&](int neighborVertex, int weight, int edgeId) {
+                if (weight >= vertexKey[neighborVertex])
+                {
+                    return;
+                }
+                if (vertexKey[neighborVertex] == NOT_SEEN)
+                {
+                    touchedVertices.push_back(neighborVertex);
+                }
+
+                int neighborOwner = owner[neighborVertex].load(std::memory_order_relaxed);
+                if (neighborOwner == treeId || (neighborOwner != UNCLAIMED && absorbedInto[neighborOwner] == treeId))
+                {
+                    vertexKey[neighborVertex] = IN_TREE;
+                    return;
+                }
+                vertexKey[neighborVertex] = weight;
+
+                HeapNodeType*& handle = (neighborOwner == UNCLAIMED) ? frontierHandle[neighborVertex]
+                                                                     : frontierHandle[numberOfVertices + neighborOwner];
+                if (handle == nullptr)
+                {
+                    handle = heap->Insert(weight, edgeId);
+                    if (neighborOwner != UNCLAIMED)
+                    {
+                        treeKey[neighborOwner] = weight;
+                        frontierTrees.push_back(neighborOwner);
+                    }
+                }
+                else if (neighborOwner == UNCLAIMED || weight < treeKey[neighborOwner])
+                {
+                    handle->vertexId = edgeId;
+                    heap->DecreaseKey(handle, weight);
+                    if (neighborOwner != UNCLAIMED)
+                    {
+                        treeKey[neighborOwner] = weight;
+                    }
+                }
+            };
+
+            while (claimedVertex >= 0)
+            {
+                const Edge* outgoingEdges = graph.NeighborEdges(claimedVertex, decodedEdges.data());
+                int outgoingEdgeCount = graph.Degree(claimedVertex);
+                int improvedEdgeCount = findImprovedEdges(outgoingEdges, outgoingEdgeCount, 0,
+                                                          vertexKey.data(), improvedEdgeIndices.data());
+
+                for (int improvedIndex = 0; improvedIndex < improvedEdgeCount; improvedIndex++)
+                {
+                    int edgeIndex = improvedEdgeIndices[improvedIndex];
+                    addFrontierEdge(outgoingEdges[edgeIndex].to, outgoingEdges[edgeIndex].weight,
+                                    (int)(edgeOffsets[claimedVertex] + edgeIndex));
+                }
+
+                // Take the lightest edge leaving the tree. An unclaimed endpoint is claimed; a
+                // parked tree at the other end is absorbed, heap and all, and the search goes on;
+                // a tree that is still growing makes this one park until someone absorbs it.
+                claimedVertex = -1;
+                while (heap->Count() > 0)
+                {
+                    HeapNodeType* minimumHeapNode = heap->FindMin();
+                    int edgeId = minimumHeapNode->vertexId;
+                    int target = edgeTarget[edgeId];
+
+                    // The top entry leaves the heap in every case but a park; the frontier
+                    // handle that points at it must not outlive it.
+                    if (frontierHandle[target] == minimumHeapNode)
+                    {
+                        frontierHandle[target] = nullptr;
+                    }
+
+                    expected = UNCLAIMED;
+                    if (owner[target].compare_exchange_strong(expected, treeId))
+                    {
+                        heap->ReleaseNode(heap->DeleteMin());
+                        forestEdges.push_back(edgeId);
+                        claimedVertex = target;
+                        break;
+                    }
+                    if (frontierHandle[numberOfVertices + expected] == minimumHeapNode)
+                    {
+                        frontierHandle[numberOfVertices + expected] = nullptr;
+                    }
+                    if (expected == treeId || absorbedInto[expected] == treeId)
+                    {
+                        heap->ReleaseNode(heap->DeleteMin());
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(forestMutex);
+                    int component = findComponent(expected);
+                    if (component == treeId)
+                    {
+                        lock.unlock();
+                        absorbedInto[expected] = treeId;
+                        heap->ReleaseNode(heap->DeleteMin());
+                        continue;
+                    }
+                    if (!parked[component])
+                    {
+                        // Waits only ever point at lower ids, so they cannot form a cycle.
+                        if (component < treeId)
+                        {
+                            forestChanged.wait(lock);
+                            continue;
+                        }
+                        parked[treeId] = true;
+                        heaps[treeId] = std::move(heap);
+                        growingTrees--;
+                        forestChanged.notify_all();
+                        break;
+                    }
+
+                    parked[component] = false;
+                    componentLink[component] = treeId;
+                    std::unique_ptr<HeapType> absorbed = std::move(heaps[component]);
+                    liveTrees--;
+                    forestChanged.notify_all();
+                    lock.unlock();
+                    absorbedInto[component] = treeId;
+
+                    // The parked heap is folded in rather than melded: its entries go through
+                    // addFrontierEdge, so those that are internal now or duplicate a lighter
+                    // entry of this tree are dropped here instead of being popped later.
+                    heap->ReleaseNode(heap->DeleteMin());
+                    absorbed->ForEachNode([&](HeapNodeType* node) {
+                        addFrontierEdge(edgeTarget[node->vertexId], node->priorityKey, node->vertexId);
+                    });
+                    absorbed->Clear();
+                    forestEdges.push_back(edgeId);
+                    phaseOneMeldCount++;
+                }
+            }
+
+            // A tree whose frontier ran dry is a whole connected component; it parks as well,
+            // so that phase 2 sees every component.
+            if (heap != nullptr)
+            {
+                std::lock_guard<std::mutex> lock(forestMutex);
+                parked[treeId] = true;
+                heaps[treeId] = std::move(heap);
+                liveTrees--;
+                growingTrees--;
+                forestChanged.notify_all();
+            }
+
+            // Entries stay in the parked heap, but the next tree starts with an empty frontier.
+            for (int index = 0; index < (int)touchedVertices.size(); index++)
+            {
+                vertexKey[touchedVertices[index]] = NOT_SEEN;
+                frontierHandle[touchedVertices[index]] = nullptr;
+            }
+            touchedVertices.clear();
+            for (int index = 0; index < (int)frontierTrees.size(); index++)
+            {
+                frontierHandle[numberOfVertices + frontierTrees[index]] = nullptr;
+            }
+            frontierTrees.clear();
+        }
+    };
+
+    for (int threadIndex = 1; threadIndex < threadCount; threadIndex++)
+    {
+        workers.emplace_back(growTrees, threadIndex);
+    }
+    growTrees(0);
+    for (int threadIndex = 0; threadIndex < (int)workers.size(); threadIndex++)
+    {
+        workers[threadIndex].join();
+    }
+    workers.clear();
+
+    std::vector<int> forestEdges;
+    for (int threadIndex = 0; threadIndex < threadCount; threadIndex++)
+    {
+        forestEdges.insert(forestEdges.end(), threadForestEdges[threadIndex].begin(), threadForestEdges[threadIndex].end());
+    }
+
+    // Every tree is now parked or absorbed. Tree ids whose claim lost a race own nothing.
+    int treeCount = nextTreeId.load();
+    std::vector<int> componentSize(treeCount, 1);
+    std::vector<int> activeComponents;
+    for (int tree = 0; tree < treeCount; tree++)
+    {
+        componentLink[tree] = FindTreeComponent(componentLink, tree);
+        if (componentLink[tree] == tree && heaps[tree] != nullptr)
+        {
+            activeComponents.push_back(tree);
+        }
+    }
+
+    parallelPrimStats = {grownTreeCount.load(), 0, phaseOneMeldCount.load()};
+
+    std::vector<int> chosenEdge(treeCount, -1);
+
+    while (!activeComponents.empty())
+    {
+        std::atomic<int> nextComponent(0);
+
+        auto findLightestOutgoingEdges = [&]() {
+            while (true)
+            {
+                int componentIndex = nextComponent.fetch_add(1);
+                if (componentIndex >= (int)activeComponents.size())
+                {
+                    break;
+                }
+
+                int component = activeComponents[componentIndex];
+                HeapType& heap = *heaps[component];
+                chosenEdge[component] = -1;
+
+                while (heap.Count() > 0)
+                {
+                    int edgeId = heap.FindMin()->vertexId;
+                    if (FindTreeComponent(componentLink, owner[edgeTarget[edgeId]].load(std::memory_order_relaxed)) != component)
+                    {
+                        chosenEdge[component] = edgeId;
+                        break;
+                    }
+                    heap.ReleaseNode(heap.DeleteMin());
+                }
+            }
+        };
+
+        int roundThreads = std::min(threadCount, (int)activeComponents.size());
+        for (int threadIndex = 1; threadIndex < roundThreads; threadIndex++)
+        {
+            workers.emplace_back(findLightestOutgoingEdges);
+        }
+        findLightestOutgoingEdges();
+        for (int threadIndex = 0; threadIndex < (int)workers.size(); threadIndex++)
+        {
+            workers[threadIndex].join();
+        }
+        workers.clear();
+
+        bool joinedAny = false;
+        for (int componentIndex = 0; componentIndex < (int)activeComponents.size(); componentIndex++)
+        {
+            int edgeId = chosenEdge[activeComponents[componentIndex]];
+            if (edgeId < 0)
+            {
+                continue;
+            }
+
+            int a = FindTreeComponent(componentLink, owner[edgeSource(edgeId)].load(std::memory_order_relaxed));
+            int b = FindTreeComponent(componentLink, owner[edgeTarget[edgeId]].load(std::memory_order_relaxed));
+            if (a == b)
+            {
+                continue;
+            }
+
+            if (componentSize[a] < componentSize[b])
+            {
+                std::swap(a, b);
+            }
+            componentLink[b] = a;
+            componentSize[a] += componentSize[b];
+            heaps[a]->Meld(*heaps[b]);
+            heaps[b].reset();
+
+            forestEdges.push_back(edgeId);
+            parallelPrimStats.meldCount++;
+            joinedAny = true;
+        }
+
+        if (!joinedAny)
+        {
+            break;
+        }
+        parallelPrimStats.boruvkaRounds++;
+
+        // Flatten the links so the next round's lookups take one step.
+        std::vector<int> survivors;
+        for (int tree = 0; tree < treeCount; tree++)
+        {
+            componentLink[tree] = FindTreeComponent(componentLink, tree);
+        }
+        for (int componentIndex = 0; componentIndex < (int)activeComponents.size(); componentIndex++)
+        {
+            int component = activeComponents[componentIndex];
+            if (componentLink[component] == component && heaps[component]->Count() > 0)
+            {
+                survivors.push_back(component);
+            }
+        }
+        activeComponents.swap(survivors);
+    }
+
+    for (int tree = 0; tree < treeCount; tree++)
+    {
+        if (heaps[tree] != nullptr)
+        {
+            heaps[tree]->Clear();
+        }
+    }
+
+    // Orient the forest edges of the component of startVertex away from it. Each source is
+    // looked up once.
+    std::vector<int> forestSource(forestEdges.size());
+    std::vector<int> forestOffsets(numberOfVertices + 1, 0);
+    for (int index = 0; index < (int)forestEdges.size(); index++)
+    {
+        forestSource[index] = edgeSource(forestEdges[index]);
+        forestOffsets[forestSource[index] + 1]++;
+        forestOffsets[edgeTarget[forestEdges[index]] + 1]++;
+    }
+    for (int v = 0; v < numberOfVertices; v++)
+    {
+        forestOffsets[v + 1] += forestOffsets[v];
+    }
+
+    // Each entry is an index into forestEdges; the neighbor is whichever endpoint is not the
+    // list owner.
+    std::vector<int> forestAdjacency(forestOffsets[numberOfVertices]);
+    std::vector<int> fillPosition(forestOffsets.begin(), forestOffsets.end() - 1);
+    for (int index = 0; index < (int)forestEdges.size(); index++)
+    {
+        forestAdjacency[fillPosition[forestSource[index]]++] = index;
+        forestAdjacency[fillPosition[edgeTarget[forestEdges[index]]]++] = index;
+    }
+
+    std::vector<int> parentVertexInMST(numberOfVertices, -1);
+    std::vector<bool> visited(numberOfVertices, false);
+    std::vector<int> queue;
+    queue.push_back(startVertex);
+    visited[startVertex] = true;
+    int totalMSTWeight = 0;
+
+    std::vector<Edge> decodedEdges(graph.MaxDegree(), Edge(0, 0));
+    for (int queueIndex = 0; queueIndex < (int)queue.size(); queueIndex++)
+    {
+        int u = queue[queueIndex];
+        for (int index = forestOffsets[u]; index < forestOffsets[u + 1]; index++)
+        {
+            int edgeId = forestEdges[forestAdjacency[index]];
+            int source = forestSource[forestAdjacency[index]];
+            int v = (source == u) ? edgeTarget[edgeId] : source;
+            if (visited[v])
+            {
+                continue;
+            }
+
+            visited[v] = true;
+            parentVertexInMST[v] = u;
+            totalMSTWeight += graph.NeighborEdges(source, decodedEdges.data())[edgeId - edgeOffsets[source]].weight;
+            queue.push_back(v);
+        }
+    }
+
+    return {parentVertexInMST, totalMSTWeight};
+}
+
+template <typename GraphType>
+static std::pair<std::vector<int>, int>
+ParallelPrimUsingPairingHeap(const GraphType& graph, int startVertex, int threadCount,
+                             PairingHeapMergeStrategy mergeStrategy = PairingHeapMergeStrategy::TwoPass)
+{
+    return ParallelPrimImplementation<PairingHeap, PairingHeapNode, GraphType>(
+        graph, startVertex, threadCount, [mergeStrategy]() { return new PairingHeap(mergeStrategy); });
+}
+
+template <typename GraphType>
+static std::pair<std::vector<int>, int>
+ParallelPrimUsingFibonacciHeap(const GraphType& graph, int startVertex, int threadCount)
+{
+    return ParallelPrimImplementation<FibonacciHeap, FibonacciHeapNode, GraphType>(
+        graph, startVertex, threadCount, []() { return new FibonacciHeap(); });
+}
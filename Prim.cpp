@@ -6,13 +6,19 @@
 #include "Graph.cpp"
 #include "PairingHeap.cpp"
 #include "FibonacciHeap.cpp"
+#include "BucketQueue.cpp"
+#include "CompressedGraph.cpp"
+#include "Relaxation.cpp"
 #endif
 
-template <typename HeapType, typename HeapNodeType>
+// GraphType is Graph or CompressedGraph: anything with Count, Degree, MaxDegree and
+// NeighborEdges(u, scratch), which returns the neighbors of u as a contiguous Edge array.
+template <typename HeapType, typename HeapNodeType, typename GraphType>
 static std::pair<std::vector<int>, int>
-PrimImplementation(const Graph& graph, int startVertex)
+PrimImplementation(const GraphType& graph, int startVertex, HeapType& priorityQueue)
 {
     const int INF = std::numeric_limits<int>::max() / 4;
+    const int IN_MST = std::numeric_limits<int>::min();
 
     int numberOfVertices = graph.Count();
 
@@ -22,8 +28,11 @@ PrimImplementation(const Graph& graph, int startVertex)
 
     bestEdgeWeightToReachVertex[startVertex] = 0;
 
-    HeapType priorityQueue;
     std::vector<HeapNodeType*> heapNodeHandleForVertex(numberOfVertices, nullptr);
+    std::vector<int> improvedEdgeIndices(graph.MaxDegree());
+    std::vector<Edge> decodedEdges(graph.MaxDegree(), Edge(0, 0));
+    RelaxationKernel findImprovedEdges = activeRelaxationKernel;
+    bool stageDecreaseKeys = stageRelaxedDecreaseKeys;
 
     for (int currentVertex = 0; currentVertex < numberOfVertices; currentVertex++)
     {
@@ -37,6 +46,7 @@ PrimImplementation(const Graph& graph, int startVertex)
     {
         HeapNodeType* minimumHeapNode = priorityQueue.DeleteMin();
         int vertexWithSmallestKey = minimumHeapNode->vertexId;
+        priorityQueue.ReleaseNode(minimumHeapNode);
 
         if (vertexIsAlreadyInMST[vertexWithSmallestKey])
         {
@@ -52,15 +62,31 @@ PrimImplementation(const Graph& graph, int startVertex)
 
         totalMSTWeight += bestEdgeWeightToReachVertex[vertexWithSmallestKey];
 
-        for (int outgoingEdgeIndex = 0; outgoingEdgeIndex < (int)graph.adj[vertexWithSmallestKey].size(); outgoingEdgeIndex++)
-        {
-            const Edge& outgoingEdge = graph.adj[vertexWithSmallestKey][outgoingEdgeIndex];
-            int neighborVertex = outgoingEdge.to;
+        // Vertices already in the tree get a key below every edge weight, so the kernel never
+        // reports them and the vertexIsAlreadyInMST test can stay out of the edge loop.
+        bestEdgeWeightToReachVertex[vertexWithSmallestKey] = IN_MST;
+
+        const Edge* outgoingEdges = graph.NeighborEdges(vertexWithSmallestKey, decodedEdges.data());
+        int outgoingEdgeCount = graph.Degree(vertexWithSmallestKey);
+        int improvedEdgeCount = findImprovedEdges(outgoingEdges, outgoingEdgeCount, 0,
+                                                  bestEdgeWeightToReachVertex.data(), improvedEdgeIndices.data());
 
-            if (vertexIsAlreadyInMST[neighborVertex])
+        for (int improvedIndex = 0; improvedIndex < improvedEdgeCount; improvedIndex++)
+        {
+            // Same two-stage prefetch as DijkstraImplementation.
+            if (PQ_PREFETCH_ENABLED && improvedIndex + PQ_PREFETCH_DISTANCE < improvedEdgeCount)
             {
-                continue;
+                int upcomingVertex = outgoingEdges[improvedEdgeIndices[improvedIndex + PQ_PREFETCH_DISTANCE]].to;
+                PQ_PREFETCH(&heapNodeHandleForVertex[upcomingVertex]);
+                PQ_PREFETCH_WRITE(&parentVertexInMST[upcomingVertex]);
             }
+            if (PQ_PREFETCH_ENABLED && improvedIndex + 1 < improvedEdgeCount)
+            {
+                PQ_PREFETCH_WRITE(heapNodeHandleForVertex[outgoingEdges[improvedEdgeIndices[improvedIndex + 1]].to]);
+            }
+
+            const Edge& outgoingEdge = outgoingEdges[improvedEdgeIndices[improvedIndex]];
+            int neighborVertex = outgoingEdge.to;
 
             int weight = outgoingEdge.weight;
 
@@ -69,22 +95,52 @@ PrimImplementation(const Graph& graph, int startVertex)
                 bestEdgeWeightToReachVertex[neighborVertex] = weight;
                 parentVertexInMST[neighborVertex] = vertexWithSmallestKey;
 
-                priorityQueue.DecreaseKey(heapNodeHandleForVertex[neighborVertex], weight);
+                if (stageDecreaseKeys)
+                {
+                    priorityQueue.StageDecreaseKey(heapNodeHandleForVertex[neighborVertex], weight);
+                }
+                else
+                {
+                    priorityQueue.DecreaseKey(heapNodeHandleForVertex[neighborVertex], weight);
+                }
             }
         }
+
+        if (stageDecreaseKeys)
+        {
+            priorityQueue.ApplyStagedDecreaseKeys();
+        }
     }
 
+    // Vertices unreachable from the start are still queued when the loop breaks; Clear drops
+    // them without the timed DeleteMin calls a drain would add to the stats.
+    priorityQueue.Clear();
+
     return {parentVertexInMST, totalMSTWeight};
 }
 
+template <typename GraphType>
+static std::pair<std::vector<int>, int>
+PrimUsingPairingHeap(const GraphType& graph, int startVertex,
+                     PairingHeapMergeStrategy mergeStrategy = PairingHeapMergeStrategy::TwoPass)
+{
+    PairingHeap priorityQueue(mergeStrategy);
+    return PrimImplementation<PairingHeap, PairingHeapNode, GraphType>(graph, startVertex, priorityQueue);
+}
+
+template <typename GraphType>
 static std::pair<std::vector<int>, int>
-PrimUsingPairingHeap(const Graph& graph, int startVertex)
+PrimUsingFibonacciHeap(const GraphType& graph, int startVertex)
 {
-    return PrimImplementation<PairingHeap, PairingHeapNode>(graph, startVertex);
+    FibonacciHeap priorityQueue;
+    return PrimImplementation<FibonacciHeap, FibonacciHeapNode, GraphType>(graph, startVertex, priorityQueue);
 }
 
+// Prim keys are edge weights, so the window of DijkstraUsingBucketQueue covers all of them.
+template <typename GraphType>
 static std::pair<std::vector<int>, int>
-PrimUsingFibonacciHeap(const Graph& graph, int startVertex)
+PrimUsingBucketQueue(const GraphType& graph, int startVertex, int maxEdgeWeight)
 {
-    return PrimImplementation<FibonacciHeap, FibonacciHeapNode>(graph, startVertex);
-}
\ No newline at end of file
+    BucketQueue priorityQueue(maxEdgeWeight);
+    return PrimImplementation<BucketQueue, BucketQueueNode, GraphType>(graph, startVertex, priorityQueue);
+}
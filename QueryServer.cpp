@@ -0,0 +1,506 @@
+#include <vector>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstring>
+#include <atomic>
+#include <cerrno>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define QUERY_SERVER_HAS_UNIX_SOCKETS
+#endif
+
+#ifndef UNITY_BUILD
+#include "LatencyHistogram.cpp"
+#include "Graph.cpp"
+#include "PairingHeap.cpp"
+#include "Prim.cpp"
+#include "DijkstraQuery.cpp"
+#endif
+
+// Query protocol, one query per line:
+//   sp <s> <t>        shortest s-t distance and path
+//   sssp <s>          full single-source run: number of reached vertices and largest distance
+//   radius <s> <R>    every vertex within distance R, as vertex:distance pairs
+//   knn <s> <k>       the k closest vertices, as vertex:distance pairs (none for k <= 0)
+//   mst <s>           weight and edge count of the MST of the component of s
+// Each answer is one line starting with the 0-based number of its query. Answers are written
+// as soon as they are computed, so they can come back out of order.
+struct QueryServerOptions
+{
+    int workerCount;
+    int batchSize;
+};
+
+struct QueryServerStats
+{
+    long long queryCount;
+    double elapsedSeconds;
+    double queriesPerSecond;
+    double p50LatencyUs;
+    double p99LatencyUs;
+    // Set when writeLine failed and the session ended before every query was answered.
+    bool outputClosed;
+    HeapOperationStats heapStats;
+};
+
+struct ServerQuery
+{
+    long long id;
+    std::string text;
+    std::chrono::steady_clock::time_point arrival;
+};
+
+// State owned by one worker thread and kept across sessions, so the per-vertex arrays of the
+// workspace are allocated once per thread rather than once per query.
+struct QueryWorkerState
+{
+    DijkstraWorkspace<PairingHeapNode> workspace;
+    std::vector<long long> latenciesNs;
+    PairingHeapStats heapStats;
+};
+
+static bool ParseQueryVertex(std::istringstream& in, const Graph& graph, int& vertex)
+{
+    return (bool)(in >> vertex) && vertex >= 0 && vertex < graph.Count();
+}
+
+static void AppendSettledPairs(std::ostringstream& out, const DijkstraQueryResult& result)
+{
+    for (int index = 0; index < (int)result.settledVertices.size(); index++)
+    {
+        out << " " << result.settledVertices[index] << ":" << result.settledDistances[index];
+    }
+}
+
+// Answers one query line. Malformed queries get an "error" answer instead of stopping the
+// session.
+static std::string AnswerQuery(const Graph& graph, const std::string& text, DijkstraWorkspace<PairingHeapNode>& workspace)
+{
+    std::istringstream in(text);
+    std::ostringstream out;
+    std::string kind;
+    int source = 0;
+
+    in >> kind;
+    if (!ParseQueryVertex(in, graph, source))
+    {
+        return "error bad source vertex";
+    }
+
+    if (kind == "sp")
+    {
+        DijkstraQuery query;
+        int target = 0;
+        if (!ParseQueryVertex(in, graph, target))
+        {
+            return "error bad target vertex";
+        }
+        query.targets.push_back(target);
+
+        DijkstraQueryResult result = DijkstraQueryUsingPairingHeap(graph, source, query, workspace);
+        if (result.firstTargetReached < 0)
+        {
+            out << "sp " << source << " " << target << " unreachable";
+            return out.str();
+        }
+
+        // The workspace keeps the predecessors until the next query on this thread.
+        std::vector<int> path;
+        for (int v = target; v != -1; v = workspace.previous[v])
+        {
+            path.push_back(v);
+        }
+        std::reverse(path.begin(), path.end());
+
+        out << "sp " << source << " " << target << " " << result.settledDistances.back() << " path";
+        for (int index = 0; index < (int)path.size(); index++)
+        {
+            out << " " << path[index];
+        }
+    }
+    else if (kind == "sssp")
+    {
+        DijkstraQueryResult result = DijkstraQueryUsingPairingHeap(graph, source, DijkstraQuery(), workspace);
+        out << "sssp " << source << " reached " << result.settledVertices.size()
+            << " max_distance " << result.settledDistances.back();
+    }
+    else if (kind == "radius" || kind == "knn")
+    {
+        int parameter = 0;
+        if (!(in >> parameter) || (kind == "radius" && parameter < 0))
+        {
+            return "error bad " + kind + " parameter";
+        }
+
+        DijkstraQuery query;
+        if (kind == "radius")
+        {
+            query.distanceLimit = parameter;
+        }
+        else
+        {
+            // A settledLimit of 0 or less settles nothing, so "knn s k" with k <= 0 answers with
+            // no vertices.
+            query.settledLimit = parameter;
+        }
+
+        DijkstraQueryResult result = DijkstraQueryUsingPairingHeap(graph, source, query, workspace);
+        out << kind << " " << source << " " << parameter << " count " << result.settledVertices.size();
+        AppendSettledPairs(out, result);
+    }
+    else if (kind == "mst")
+    {
+        std::pair<std::vector<int>, int> mst = PrimUsingPairingHeap(graph, source);
+        int treeEdges = (int)std::count_if(mst.first.begin(), mst.first.end(), [](int parent) { return parent != -1; });
+        out << "mst " << source << " weight " << mst.second << " edges " << treeEdges;
+    }
+    else
+    {
+        return "error unknown query " + kind;
+    }
+
+    return out.str();
+}
+
+// Serves query streams over one in-memory graph. Each session starts options.workerCount
+// threads. They take queued queries in batches of up to options.batchSize, with one lock
+// acquisition per batch, and write each answer as soon as it is ready.
+class QueryServer
+{
+private:
+    const Graph& graph;
+    QueryServerOptions options;
+    std::vector<QueryWorkerState> workerStates;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<ServerQuery> pendingQueries;
+    bool inputClosed;
+
+    std::mutex outputMutex;
+    // Set by the first failed writeLine; the session stops reading and drops queued queries.
+    std::atomic<bool> outputClosed;
+
+    void WorkerLoop(QueryWorkerState& state, const std::function<bool(const std::string&)>& writeLine);
+
+public:
+    QueryServer(const Graph& graph, const QueryServerOptions& options);
+
+    // Reads queries with readLine until it returns false and answers them through writeLine.
+    // Returns once every query has been answered, or as soon as writeLine returns false (the
+    // client is gone), without answering the rest.
+    QueryServerStats RunSession(const std::function<bool(std::string&)>& readLine,
+                                const std::function<bool(const std::string&)>& writeLine);
+};
+
+QueryServer::QueryServer(const Graph& graph, const QueryServerOptions& options)
+    : graph(graph), options(options), workerStates(std::max(1, options.workerCount))
+{
+    inputClosed = false;
+    outputClosed = false;
+}
+
+void QueryServer::WorkerLoop(QueryWorkerState& state, const std::function<bool(const std::string&)>& writeLine)
+{
+    std::vector<ServerQuery> batch;
+    ResetPairingHeapStats();
+
+    while (true)
+    {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this]() { return !pendingQueries.empty() || inputClosed; });
+
+            if (pendingQueries.empty())
+            {
+                state.heapStats = GetPairingHeapStats();
+                return;
+            }
+
+            // Never take more than an even share of the backlog, so one worker does not sit on a
+            // batch while the others are idle.
+            int batchLimit = std::min(options.batchSize, std::max(1, (int)pendingQueries.size() / (int)workerStates.size()));
+            while (!pendingQueries.empty() && (int)batch.size() < batchLimit)
+            {
+                batch.push_back(std::move(pendingQueries.front()));
+                pendingQueries.pop_front();
+            }
+        }
+
+        for (int index = 0; index < (int)batch.size() && !outputClosed; index++)
+        {
+            std::string answer = std::to_string(batch[index].id) + " " + AnswerQuery(graph, batch[index].text, state.workspace);
+
+            bool written = false;
+            {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                written = !outputClosed && writeLine(answer);
+            }
+            if (!written)
+            {
+                outputClosed = true;
+                std::lock_guard<std::mutex> lock(queueMutex);
+                pendingQueries.clear();
+                break;
+            }
+
+            auto finished = std::chrono::steady_clock::now();
+            state.latenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(finished - batch[index].arrival).count());
+        }
+    }
+}
+
+QueryServerStats QueryServer::RunSession(const std::function<bool(std::string&)>& readLine,
+                                         const std::function<bool(const std::string&)>& writeLine)
+{
+    inputClosed = false;
+    outputClosed = false;
+    for (int workerIndex = 0; workerIndex < (int)workerStates.size(); workerIndex++)
+    {
+        workerStates[workerIndex].latenciesNs.clear();
+    }
+
+    auto sessionStart = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int workerIndex = 0; workerIndex < (int)workerStates.size(); workerIndex++)
+    {
+        workers.emplace_back(&QueryServer::WorkerLoop, this, std::ref(workerStates[workerIndex]), std::cref(writeLine));
+    }
+
+    long long nextQueryId = 0;
+    std::string line;
+    while (!outputClosed && readLine(line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (outputClosed)
+            {
+                break;
+            }
+            pendingQueries.push_back({nextQueryId++, line, std::chrono::steady_clock::now()});
+        }
+        queueReady.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        inputClosed = true;
+    }
+    queueReady.notify_all();
+
+    for (int workerIndex = 0; workerIndex < (int)workers.size(); workerIndex++)
+    {
+        workers[workerIndex].join();
+    }
+
+    auto sessionEnd = std::chrono::steady_clock::now();
+
+    QueryServerStats stats;
+    std::vector<long long> latenciesNs;
+    for (int workerIndex = 0; workerIndex < (int)workerStates.size(); workerIndex++)
+    {
+        stats.heapStats.Merge(workerStates[workerIndex].heapStats);
+        latenciesNs.insert(latenciesNs.end(), workerStates[workerIndex].latenciesNs.begin(),
+                           workerStates[workerIndex].latenciesNs.end());
+    }
+    std::sort(latenciesNs.begin(), latenciesNs.end());
+
+    stats.queryCount = (long long)latenciesNs.size();
+    stats.elapsedSeconds = std::chrono::duration<double>(sessionEnd - sessionStart).count();
+    stats.queriesPerSecond = (stats.elapsedSeconds > 0) ? (double)stats.queryCount / stats.elapsedSeconds : 0.0;
+    stats.p50LatencyUs = latenciesNs.empty() ? 0.0 : latenciesNs[latenciesNs.size() / 2] / 1000.0;
+    stats.p99LatencyUs = latenciesNs.empty() ? 0.0 : latenciesNs[(latenciesNs.size() * 99) / 100] / 1000.0;
+    stats.outputClosed = outputClosed;
+    return stats;
+}
+
+#ifdef QUERY_SERVER_HAS_UNIX_SOCKETS
+
+// Buffered line reader over a socket descriptor.
+class DescriptorLineReader
+{
+private:
+    int descriptor;
+    std::string buffer;
+    size_t position;
+
+public:
+    explicit DescriptorLineReader(int descriptor) : descriptor(descriptor), position(0) {}
+
+    bool ReadLine(std::string& line)
+    {
+        while (true)
+        {
+            size_t newline = buffer.find('\n', position);
+            if (newline != std::string::npos)
+            {
+                line.assign(buffer, position, newline - position);
+                position = newline + 1;
+                return true;
+            }
+
+            buffer.erase(0, position);
+            position = 0;
+
+            char chunk[4096];
+            ssize_t received = read(descriptor, chunk, sizeof(chunk));
+            if (received <= 0)
+            {
+                if (buffer.empty())
+                {
+                    return false;
+                }
+                line.swap(buffer);
+                buffer.clear();
+                return true;
+            }
+            buffer.append(chunk, (size_t)received);
+        }
+    }
+};
+
+// MSG_NOSIGNAL turns a write to a client that has hung up into EPIPE instead of a SIGPIPE that
+// kills the server; platforms without it get SO_NOSIGPIPE on the socket in AcceptClient.
+#ifdef MSG_NOSIGNAL
+static const int QUERY_SERVER_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int QUERY_SERVER_SEND_FLAGS = 0;
+#endif
+
+// Returns false once the client can no longer be written to.
+static bool WriteAll(int descriptor, const std::string& data)
+{
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t result = send(descriptor, data.data() + written, data.size() - written, QUERY_SERVER_SEND_FLAGS);
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (result <= 0)
+        {
+            return false;
+        }
+        written += (size_t)result;
+    }
+    return true;
+}
+
+// Waits for the next client. Aborted connections and interrupts are retried at once; running
+// out of descriptors or memory backs off for a moment instead of spinning, since accept keeps
+// failing until a descriptor is freed. Any other error throws.
+static int AcceptClient(int listener)
+{
+    while (true)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client >= 0)
+        {
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+            int enable = 1;
+            setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+            return client;
+        }
+
+        if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO)
+        {
+            continue;
+        }
+        if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        throw std::runtime_error(std::string("accept failed: ") + std::strerror(errno));
+    }
+}
+
+// Accepts one client at a time on a Unix socket at path and serves its queries until it
+// disconnects. A client that hangs up before all answers are written only ends its own session.
+// A client line "shutdown" ends its session and stops the server.
+static void ServeQueriesOnUnixSocket(QueryServer& server, const std::string& path,
+                                     const std::function<void(const QueryServerStats&)>& reportStats)
+{
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        throw std::runtime_error("Cannot create Unix socket");
+    }
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        close(listener);
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    unlink(path.c_str());
+
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0)
+    {
+        close(listener);
+        throw std::runtime_error("Cannot listen on " + path);
+    }
+
+    bool shutdownRequested = false;
+    while (!shutdownRequested)
+    {
+        int client = -1;
+        try
+        {
+            client = AcceptClient(listener);
+        }
+        catch (const std::exception&)
+        {
+            close(listener);
+            unlink(path.c_str());
+            throw;
+        }
+
+        DescriptorLineReader reader(client);
+        QueryServerStats stats = server.RunSession(
+            [&reader, &shutdownRequested](std::string& line) {
+                if (!reader.ReadLine(line))
+                {
+                    return false;
+                }
+                if (line == "shutdown")
+                {
+                    shutdownRequested = true;
+                    return false;
+                }
+                return true;
+            },
+            [client](const std::string& answer) { return WriteAll(client, answer + "\n"); });
+
+        close(client);
+        reportStats(stats);
+    }
+
+    close(listener);
+    unlink(path.c_str());
+}
+
+#endif
@@ -0,0 +1,247 @@
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define RELAXATION_HAS_X86_KERNELS 1
+#endif
+
+#ifndef UNITY_BUILD
+#include "Graph.cpp"
+#include "Prefetch.cpp"
+#endif
+
+static_assert(sizeof(Edge) == 2 * sizeof(int), "Relaxation kernels read Edge arrays as packed (to, weight) int pairs");
+
+// Writes the index of every edge whose candidate key (baseKey + weight) is strictly smaller
+// than currentKey[edge.to] and returns how many indices were written. The caller must re-check
+// each reported edge before applying it, because parallel edges to the same vertex inside one
+// block are all compared against the key from before the block.
+typedef int (*RelaxationKernel)(const Edge* edges, int edgeCount, int baseKey, const int* currentKey, int* improvedEdgeIndices);
+
+enum class RelaxationKernelKind
+{
+    Auto,
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+static int FindImprovedEdgesScalar(const Edge* edges, int edgeCount, int baseKey, const int* currentKey, int* improvedEdgeIndices)
+{
+    int improvedCount = 0;
+
+    for (int edgeIndex = 0; edgeIndex < edgeCount; edgeIndex++)
+    {
+        // The key reads are random accesses; the SIMD kernels issue them together as one gather,
+        // so only this loop gains from fetching them ahead of the compare.
+        if (PQ_PREFETCH_ENABLED && edgeIndex + PQ_PREFETCH_DISTANCE < edgeCount)
+        {
+            PQ_PREFETCH(&currentKey[edges[edgeIndex + PQ_PREFETCH_DISTANCE].to]);
+        }
+
+        if (baseKey + edges[edgeIndex].weight < currentKey[edges[edgeIndex].to])
+        {
+            improvedEdgeIndices[improvedCount++] = edgeIndex;
+        }
+    }
+
+    return improvedCount;
+}
+
+#ifdef RELAXATION_HAS_X86_KERNELS
+
+__attribute__((target("avx2")))
+static int FindImprovedEdgesAvx2(const Edge* edges, int edgeCount, int baseKey, const int* currentKey, int* improvedEdgeIndices)
+{
+    const int* packedEdges = reinterpret_cast<const int*>(edges);
+    const __m256i deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i base = _mm256_set1_epi32(baseKey);
+
+    int improvedCount = 0;
+    int edgeIndex = 0;
+
+    for (; edgeIndex + 8 <= edgeCount; edgeIndex += 8)
+    {
+        // Each load holds four (to, weight) pairs; split them into eight targets and eight weights.
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packedEdges + 2 * edgeIndex));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packedEdges + 2 * edgeIndex + 8));
+        low = _mm256_permutevar8x32_epi32(low, deinterleave);
+        high = _mm256_permutevar8x32_epi32(high, deinterleave);
+
+        __m256i targets = _mm256_permute2x128_si256(low, high, 0x20);
+        __m256i weights = _mm256_permute2x128_si256(low, high, 0x31);
+
+        __m256i current = _mm256_i32gather_epi32(currentKey, targets, 4);
+        __m256i candidate = _mm256_add_epi32(base, weights);
+
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(current, candidate)));
+
+        while (mask != 0)
+        {
+            improvedEdgeIndices[improvedCount++] = edgeIndex + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+
+    for (; edgeIndex < edgeCount; edgeIndex++)
+    {
+        if (baseKey + edges[edgeIndex].weight < currentKey[edges[edgeIndex].to])
+        {
+            improvedEdgeIndices[improvedCount++] = edgeIndex;
+        }
+    }
+
+    return improvedCount;
+}
+
+__attribute__((target("avx512f")))
+static int FindImprovedEdgesAvx512(const Edge* edges, int edgeCount, int baseKey, const int* currentKey, int* improvedEdgeIndices)
+{
+    const int* packedEdges = reinterpret_cast<const int*>(edges);
+    const __m512i targetLanes = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i weightLanes = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    const __m512i base = _mm512_set1_epi32(baseKey);
+
+    int improvedCount = 0;
+    int edgeIndex = 0;
+
+    for (; edgeIndex + 16 <= edgeCount; edgeIndex += 16)
+    {
+        __m512i low = _mm512_loadu_si512(packedEdges + 2 * edgeIndex);
+        __m512i high = _mm512_loadu_si512(packedEdges + 2 * edgeIndex + 16);
+
+        __m512i targets = _mm512_permutex2var_epi32(low, targetLanes, high);
+        __m512i weights = _mm512_permutex2var_epi32(low, weightLanes, high);
+
+        __m512i current = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, targets, currentKey, 4);
+        __m512i candidate = _mm512_add_epi32(base, weights);
+
+        unsigned int mask = _mm512_cmpgt_epi32_mask(current, candidate);
+
+        while (mask != 0)
+        {
+            improvedEdgeIndices[improvedCount++] = edgeIndex + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+
+    for (; edgeIndex < edgeCount; edgeIndex++)
+    {
+        if (baseKey + edges[edgeIndex].weight < currentKey[edges[edgeIndex].to])
+        {
+            improvedEdgeIndices[improvedCount++] = edgeIndex;
+        }
+    }
+
+    return improvedCount;
+}
+
+#endif
+
+static bool RelaxationKernelSupported(RelaxationKernelKind kind)
+{
+    switch (kind)
+    {
+        case RelaxationKernelKind::Auto:
+        case RelaxationKernelKind::Scalar:
+            return true;
+#ifdef RELAXATION_HAS_X86_KERNELS
+        case RelaxationKernelKind::Avx2:
+            return __builtin_cpu_supports("avx2");
+        case RelaxationKernelKind::Avx512:
+            return __builtin_cpu_supports("avx512f");
+#else
+        case RelaxationKernelKind::Avx2:
+        case RelaxationKernelKind::Avx512:
+            return false;
+#endif
+    }
+    return false;
+}
+
+static RelaxationKernelKind ResolveRelaxationKernelKind(RelaxationKernelKind requested)
+{
+    if (requested != RelaxationKernelKind::Auto)
+    {
+        return RelaxationKernelSupported(requested) ? requested : RelaxationKernelKind::Scalar;
+    }
+
+    if (RelaxationKernelSupported(RelaxationKernelKind::Avx512))
+    {
+        return RelaxationKernelKind::Avx512;
+    }
+    if (RelaxationKernelSupported(RelaxationKernelKind::Avx2))
+    {
+        return RelaxationKernelKind::Avx2;
+    }
+    return RelaxationKernelKind::Scalar;
+}
+
+static RelaxationKernel RelaxationKernelFor(RelaxationKernelKind kind)
+{
+    switch (ResolveRelaxationKernelKind(kind))
+    {
+#ifdef RELAXATION_HAS_X86_KERNELS
+        case RelaxationKernelKind::Avx2:
+            return FindImprovedEdgesAvx2;
+        case RelaxationKernelKind::Avx512:
+            return FindImprovedEdgesAvx512;
+#endif
+        default:
+            return FindImprovedEdgesScalar;
+    }
+}
+
+static const char* RelaxationKernelName(RelaxationKernelKind kind)
+{
+    switch (ResolveRelaxationKernelKind(kind))
+    {
+        case RelaxationKernelKind::Avx2:
+            return "avx2";
+        case RelaxationKernelKind::Avx512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+static bool ParseRelaxationKernelKind(const char* text, RelaxationKernelKind& kind)
+{
+    if (std::strcmp(text, "auto") == 0)
+    {
+        kind = RelaxationKernelKind::Auto;
+    }
+    else if (std::strcmp(text, "scalar") == 0)
+    {
+        kind = RelaxationKernelKind::Scalar;
+    }
+    else if (std::strcmp(text, "avx2") == 0)
+    {
+        kind = RelaxationKernelKind::Avx2;
+    }
+    else if (std::strcmp(text, "avx512") == 0)
+    {
+        kind = RelaxationKernelKind::Avx512;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+// Kernel used by DijkstraImplementation and PrimImplementation. Chosen once from the CPU at
+// startup; the benchmark driver can override it with --relaxation=.
+static RelaxationKernelKind activeRelaxationKernelKind = RelaxationKernelKind::Auto;
+static RelaxationKernel activeRelaxationKernel = RelaxationKernelFor(RelaxationKernelKind::Auto);
+
+static void SetRelaxationKernel(RelaxationKernelKind kind)
+{
+    activeRelaxationKernelKind = kind;
+    activeRelaxationKernel = RelaxationKernelFor(kind);
+}
+
+// When set, the relaxation loops stage every improvement found while scanning one vertex with
+// StageDecreaseKey and hand them to the heap together with ApplyStagedDecreaseKeys, instead of
+// calling DecreaseKey once per improved edge. Set from --batch-decrease-key.
+static bool stageRelaxedDecreaseKeys = false;
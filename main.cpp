@@ -1,14 +1,47 @@
 #include <fstream>
+#include <iostream>
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
 #include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <thread>
 
 #define UNITY_BUILD 1
 
+#include "LatencyHistogram.cpp"
 #include "Graph.cpp"
+#include "MemoryAllocation.cpp"
+#include "Prefetch.cpp"
 #include "PairingHeap.cpp"
 #include "FibonacciHeap.cpp"
+#include "BucketQueue.cpp"
+#include "CompressedGraph.cpp"
+#include "Relaxation.cpp"
 #include "Dijkstra.cpp"
 #include "Prim.cpp"
+#include "ParallelPrim.cpp"
+#include "HeapSelection.cpp"
+#include "DijkstraQuery.cpp"
+#include "DiskGraph.cpp"
+#include "ExternalPriorityQueue.cpp"
+#include "ExternalMemory.cpp"
+#include "GraphReordering.cpp"
+#include "DynamicShortestPaths.cpp"
+#include "DynamicMinimumSpanningTree.cpp"
+#include "QueryServer.cpp"
+
+static void WriteLatencyColumns(std::ofstream& out, const LatencyHistogram& latency)
+{
+    out << "," << latency.PercentileNs(50.0)
+        << "," << latency.PercentileNs(99.0)
+        << "," << latency.PercentileNs(99.9)
+        << "," << latency.MaxNs();
+}
 
 static void WriteRow(std::ofstream& out,
                      const std::string& graphType,
@@ -18,12 +51,7 @@ static void WriteRow(std::ofstream& out,
                      const std::string& heapName,
                      int trialIndex,
                      long long totalUs,
-                     long long insertCount,
-                     long long deleteMinCount,
-                     long long decreaseKeyCount,
-                     long long insertNs,
-                     long long deleteMinNs,
-                     long long decreaseKeyNs)
+                     const HeapOperationStats& stats)
 {
     out << graphType << ","
         << vertexCount << ","
@@ -32,91 +60,1326 @@ static void WriteRow(std::ofstream& out,
         << heapName << ","
         << trialIndex << ","
         << totalUs << ","
-        << insertCount << ","
-        << deleteMinCount << ","
-        << decreaseKeyCount << ","
-        << insertNs << ","
-        << deleteMinNs << ","
-        << decreaseKeyNs << "\n";
+        << stats.insertLatency.Count() << ","
+        << stats.deleteMinLatency.Count() << ","
+        << stats.decreaseKeyLatency.Count() << ","
+        << stats.insertLatency.TotalNs() << ","
+        << stats.deleteMinLatency.TotalNs() << ","
+        << stats.decreaseKeyLatency.TotalNs();
+
+    WriteLatencyColumns(out, stats.insertLatency);
+    WriteLatencyColumns(out, stats.deleteMinLatency);
+    WriteLatencyColumns(out, stats.decreaseKeyLatency);
+    out << "," << stats.stagedDecreaseKeys
+        << "," << stats.decreaseKeyBatchLatency.Count()
+        << "," << stats.decreaseKeyBatchLatency.TotalNs();
+    out << "\n";
+}
+
+static const char* benchmarkGraphNames[4] = {"random_sparse", "random_dense", "grid", "synthetic_worst"};
+
+// The four graph families of the benchmark matrix; sizeIndex 0 is the 1000-vertex set and
+// sizeIndex 1 the 5000-vertex set.
+static std::vector<Graph> MakeBenchmarkGraphs(int sizeIndex, int trial, int maxWeight)
+{
+    int n = (sizeIndex == 0) ? 1000 : 5000;
+
+    int sparseEdges = 5 * n;
+    int denseEdges = 20 * n;
+
+    Graph randomSparse = Graph::MakeRandomUndirectedGraph(n, sparseEdges, maxWeight, 1000 + trial);
+    Graph randomDense = Graph::MakeRandomUndirectedGraph(n, denseEdges, maxWeight, 2000 + trial);
+
+    int gridSide;
+    if (sizeIndex == 0)
+    {
+        gridSide = 30;
+    }
+    else
+    {
+        gridSide = 70;
+    }
+    Graph gridGraph = Graph::MakeGridUndirectedGraph(gridSide, gridSide, maxWeight, 3000 + trial);
+
+    int k = n / 4;
+    Graph worstCase = Graph::MakeSyntheticWorstCaseGraph(n, k, maxWeight);
+
+    return {randomSparse, randomDense, gridGraph, worstCase};
 }
 
-int main()
+// Besides the fixed heaps, every graph gets a bucket queue run and an auto run whose heap column
+// is "auto:<chosen heap>", so the choice can be checked against the other rows. The first trial
+// of each graph also logs the choice and the profile behind it to stderr.
+static void RunHeapBenchmark(bool calibrateAutoHeap)
 {
     std::ofstream out("results.csv");
-    out << "graph_type,vertices,edges,algorithm,heap,trial,total_us,insert_count,deletemin_count,decreasekey_count,insert_ns,deletemin_ns,decreasekey_ns\n";
+    out << "graph_type,vertices,edges,algorithm,heap,trial,total_us,insert_count,deletemin_count,decreasekey_count,insert_ns,deletemin_ns,decreasekey_ns,"
+           "insert_p50_ns,insert_p99_ns,insert_p999_ns,insert_max_ns,"
+           "deletemin_p50_ns,deletemin_p99_ns,deletemin_p999_ns,deletemin_max_ns,"
+           "decreasekey_p50_ns,decreasekey_p99_ns,decreasekey_p999_ns,decreasekey_max_ns,"
+           "staged_decreasekeys,decreasekey_batches,decreasekey_batch_ns\n";
 
     int trials = 5;
     int maxWeight = 20;
 
+    const PairingHeapMergeStrategy pairingStrategies[] = {
+        PairingHeapMergeStrategy::RecursiveTwoPass,
+        PairingHeapMergeStrategy::TwoPass,
+        PairingHeapMergeStrategy::Multipass,
+        PairingHeapMergeStrategy::FrontToBack,
+        PairingHeapMergeStrategy::Lazy
+    };
+    const int pairingStrategyCount = 5;
+
     for (int sizeIndex = 0; sizeIndex < 2; sizeIndex++)
     {
-        int n = (sizeIndex == 0) ? 1000 : 5000;
+        for (int trial = 0; trial < trials; trial++)
+        {
+            std::vector<Graph> graphs = MakeBenchmarkGraphs(sizeIndex, trial, maxWeight);
+
+            for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+            {
+                Graph& g = graphs[graphIndex];
+                int V = g.Count();
+                int E = g.UndirectedEdgeCount();
 
-        int sparseEdges = 5 * n;
-        int denseEdges = 20 * n;
+                for (int strategyIndex = 0; strategyIndex < pairingStrategyCount; strategyIndex++)
+                {
+                    PairingHeapMergeStrategy strategy = pairingStrategies[strategyIndex];
+
+                    ResetPairingHeapStats();
+                    auto start1 = std::chrono::steady_clock::now();
+                    DijkstraUsingPairingHeap(g, 0, strategy);
+                    auto end1 = std::chrono::steady_clock::now();
+                    auto s1 = GetPairingHeapStats();
+                    long long total1 = std::chrono::duration_cast<std::chrono::microseconds>(end1 - start1).count();
+                    WriteRow(out, benchmarkGraphNames[graphIndex], V, E, "dijkstra", PairingHeapMergeStrategyName(strategy), trial, total1, s1);
+                }
+
+                ResetFibonacciHeapStats();
+                auto start2 = std::chrono::steady_clock::now();
+                DijkstraUsingFibonacciHeap(g, 0);
+                auto end2 = std::chrono::steady_clock::now();
+                auto s2 = GetFibonacciHeapStats();
+                long long total2 = std::chrono::duration_cast<std::chrono::microseconds>(end2 - start2).count();
+                WriteRow(out, benchmarkGraphNames[graphIndex], V, E, "dijkstra", "fibonacci", trial, total2, s2);
+
+                for (int strategyIndex = 0; strategyIndex < pairingStrategyCount; strategyIndex++)
+                {
+                    PairingHeapMergeStrategy strategy = pairingStrategies[strategyIndex];
+
+                    ResetPairingHeapStats();
+                    auto start3 = std::chrono::steady_clock::now();
+                    PrimUsingPairingHeap(g, 0, strategy);
+                    auto end3 = std::chrono::steady_clock::now();
+                    auto s3 = GetPairingHeapStats();
+                    long long total3 = std::chrono::duration_cast<std::chrono::microseconds>(end3 - start3).count();
+                    WriteRow(out, benchmarkGraphNames[graphIndex], V, E, "prim", PairingHeapMergeStrategyName(strategy), trial, total3, s3);
+                }
+
+                ResetFibonacciHeapStats();
+                auto start4 = std::chrono::steady_clock::now();
+                PrimUsingFibonacciHeap(g, 0);
+                auto end4 = std::chrono::steady_clock::now();
+                auto s4 = GetFibonacciHeapStats();
+                long long total4 = std::chrono::duration_cast<std::chrono::microseconds>(end4 - start4).count();
+                WriteRow(out, benchmarkGraphNames[graphIndex], V, E, "prim", "fibonacci", trial, total4, s4);
+
+                ResetBucketQueueStats();
+                auto start5 = std::chrono::steady_clock::now();
+                DijkstraUsingBucketQueue(g, 0, maxWeight);
+                auto end5 = std::chrono::steady_clock::now();
+                auto s5 = GetBucketQueueStats();
+                long long total5 = std::chrono::duration_cast<std::chrono::microseconds>(end5 - start5).count();
+                WriteRow(out, benchmarkGraphNames[graphIndex], V, E, "dijkstra", "bucket", trial, total5, s5);
+
+                ResetBucketQueueStats();
+                auto start6 = std::chrono::steady_clock::now();
+                PrimUsingBucketQueue(g, 0, maxWeight);
+                auto end6 = std::chrono::steady_clock::now();
+                auto s6 = GetBucketQueueStats();
+                long long total6 = std::chrono::duration_cast<std::chrono::microseconds>(end6 - start6).count();
+                WriteRow(out, benchmarkGraphNames[graphIndex], V, E, "prim", "bucket", trial, total6, s6);
+
+                // Auto timings include profiling and, with --auto-calibrate, the calibration runs.
+                const char* autoAlgorithms[2] = {"dijkstra", "prim"};
+                for (int algorithmIndex = 0; algorithmIndex < 2; algorithmIndex++)
+                {
+                    HeapSelection selection;
+                    ResetPairingHeapStats();
+                    ResetFibonacciHeapStats();
+                    ResetBucketQueueStats();
+                    auto start7 = std::chrono::steady_clock::now();
+                    if (algorithmIndex == 0)
+                    {
+                        DijkstraUsingAutoHeap(g, 0, calibrateAutoHeap, &selection);
+                    }
+                    else
+                    {
+                        PrimUsingAutoHeap(g, 0, calibrateAutoHeap, &selection);
+                    }
+                    auto end7 = std::chrono::steady_clock::now();
+                    long long total7 = std::chrono::duration_cast<std::chrono::microseconds>(end7 - start7).count();
+                    std::string heapName = std::string("auto:") + HeapSelectionName(selection);
+                    WriteRow(out, benchmarkGraphNames[graphIndex], V, E, autoAlgorithms[algorithmIndex], heapName, trial, total7,
+                             GetSelectedHeapStats(selection));
+
+                    if (trial == 0)
+                    {
+                        std::cerr << "auto heap: " << benchmarkGraphNames[graphIndex] << " " << autoAlgorithms[algorithmIndex]
+                                  << " -> " << DescribeHeapSelection(selection) << "\n";
+                    }
+                }
+            }
+        }
+    }
+
+}
+
+static void WriteExternalRow(std::ostream& out,
+                             const std::string& graphType,
+                             int vertexCount,
+                             long long edgeCount,
+                             const std::string& algorithmName,
+                             int queueMemoryEntries,
+                             long long totalUs,
+                             const ExternalIoStats& io,
+                             const std::string& matchesInMemory)
+{
+    out << graphType << ","
+        << vertexCount << ","
+        << edgeCount << ","
+        << algorithmName << ","
+        << queueMemoryEntries << ","
+        << totalUs << ","
+        << io.bytesRead << ","
+        << io.bytesWritten << ","
+        << io.readCalls << ","
+        << io.writeCalls << ","
+        << io.ioWaitNs / 1000 << ","
+        << matchesInMemory << "\n";
+}
+
+static const char* EXTERNAL_CSV_HEADER =
+    "graph_type,vertices,edges,algorithm,queue_memory_entries,total_us,bytes_read,bytes_written,read_calls,write_calls,io_wait_us,matches_in_memory\n";
+
+static std::string ExternalSpillPrefix(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / ("pq_external_" + name)).string();
+}
+
+// Runs the out-of-core Dijkstra and Prim on the 5000-vertex graphs with a deliberately small
+// queue budget so the queue spills, and checks the results against the in-memory versions.
+static void RunExternalBenchmark(int queueMemoryEntries)
+{
+    std::ofstream out("external_results.csv");
+    out << EXTERNAL_CSV_HEADER;
+
+    std::vector<Graph> graphs = MakeBenchmarkGraphs(1, 0, 20);
+
+    for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+    {
+        Graph& g = graphs[graphIndex];
+        std::string csrPath = ExternalSpillPrefix(benchmarkGraphNames[graphIndex]) + ".csr";
+        WriteGraphToCsrFile(g, csrPath);
+
+        ExternalMemoryOptions options = DefaultExternalMemoryOptions(ExternalSpillPrefix(benchmarkGraphNames[graphIndex]));
+        options.queueMemoryEntries = queueMemoryEntries;
 
-        for (int trial = 0; trial < trials; trial++)
         {
-            Graph randomSparse = Graph::MakeRandomUndirectedGraph(n, sparseEdges, maxWeight, 1000 + trial);
-            Graph randomDense = Graph::MakeRandomUndirectedGraph(n, denseEdges, maxWeight, 2000 + trial);
+            ResetExternalIoStats();
+            auto start = std::chrono::steady_clock::now();
+            DiskGraph diskGraph(csrPath);
+            auto result = DijkstraExternalMemory(diskGraph, 0, options);
+            auto end = std::chrono::steady_clock::now();
+            ExternalIoStats io = GetExternalIoStats();
+
+            bool matches = result.first == DijkstraUsingPairingHeap(g, 0).first;
+            WriteExternalRow(out, benchmarkGraphNames[graphIndex], diskGraph.Count(), diskGraph.DirectedEdgeCount() / 2, "dijkstra", queueMemoryEntries,
+                             std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), io, matches ? "yes" : "no");
+        }
+
+        {
+            ResetExternalIoStats();
+            auto start = std::chrono::steady_clock::now();
+            DiskGraph diskGraph(csrPath);
+            auto result = PrimExternalMemory(diskGraph, 0, options);
+            auto end = std::chrono::steady_clock::now();
+            ExternalIoStats io = GetExternalIoStats();
+
+            bool matches = result.second == PrimUsingPairingHeap(g, 0).second;
+            WriteExternalRow(out, benchmarkGraphNames[graphIndex], diskGraph.Count(), diskGraph.DirectedEdgeCount() / 2, "prim", queueMemoryEntries,
+                             std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), io, matches ? "yes" : "no");
+        }
 
-            int gridSide;
-            if (sizeIndex == 0)
+        std::remove(csrPath.c_str());
+    }
+}
+
+// Runs the out-of-core Dijkstra and Prim from vertex 0 on an existing CSR file and prints one
+// CSV row per algorithm to stdout.
+static void RunExternalOnCsrFile(const std::string& csrPath, int queueMemoryEntries)
+{
+    ExternalMemoryOptions options = DefaultExternalMemoryOptions(ExternalSpillPrefix("file"));
+    options.queueMemoryEntries = queueMemoryEntries;
+
+    std::cout << EXTERNAL_CSV_HEADER;
+
+    const char* algorithmNames[2] = {"dijkstra", "prim"};
+    for (int algorithmIndex = 0; algorithmIndex < 2; algorithmIndex++)
+    {
+        ResetExternalIoStats();
+        auto start = std::chrono::steady_clock::now();
+        DiskGraph diskGraph(csrPath);
+        if (algorithmIndex == 0)
+        {
+            DijkstraExternalMemory(diskGraph, 0, options);
+        }
+        else
+        {
+            PrimExternalMemory(diskGraph, 0, options);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        WriteExternalRow(std::cout, csrPath, diskGraph.Count(), diskGraph.DirectedEdgeCount() / 2, algorithmNames[algorithmIndex], queueMemoryEntries,
+                         std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(), GetExternalIoStats(), "n/a");
+    }
+}
+
+static void WriteReorderRow(std::ofstream& out,
+                            const std::string& graphType,
+                            int vertexCount,
+                            int edgeCount,
+                            const std::string& orderingName,
+                            long long reorderUs,
+                            long long dijkstraUs,
+                            long long primUs,
+                            double dijkstraSpeedup,
+                            double primSpeedup,
+                            bool matchesOriginal)
+{
+    out << graphType << ","
+        << vertexCount << ","
+        << edgeCount << ","
+        << orderingName << ","
+        << reorderUs << ","
+        << dijkstraUs << ","
+        << primUs << ","
+        << dijkstraSpeedup << ","
+        << primSpeedup << ","
+        << (matchesOriginal ? "yes" : "no") << "\n";
+}
+
+static int EdgeWeightBetween(const Graph& graph, int from, int to)
+{
+    int lightestWeight = -1;
+    for (const Edge& edge : graph.adj[from])
+    {
+        if (edge.to == to && (lightestWeight < 0 || edge.weight < lightestWeight))
+        {
+            lightestWeight = edge.weight;
+        }
+    }
+    return lightestWeight;
+}
+
+// Ties can give a reordered run different predecessors than the original one, so instead of
+// comparing arrays this checks that every predecessor edge exists and is tight.
+static bool IsShortestPathTree(const Graph& graph, int source, const std::vector<int>& distances,
+                               const std::vector<int>& predecessors)
+{
+    for (int v = 0; v < graph.Count(); v++)
+    {
+        if (v == source || predecessors[v] < 0)
+        {
+            continue;
+        }
+        int weight = EdgeWeightBetween(graph, predecessors[v], v);
+        if (weight < 0 || distances[predecessors[v]] + weight != distances[v])
+        {
+            return false;
+        }
+    }
+    return predecessors[source] == -1;
+}
+
+// Checks that the parent edges exist, reach the root without cycles and add up to mstWeight.
+static bool IsSpanningTreeOfWeight(const Graph& graph, int root, const std::vector<int>& parents, int mstWeight)
+{
+    long long totalWeight = 0;
+    std::vector<char> reachesRoot(graph.Count(), 0);
+    reachesRoot[root] = 1;
+
+    for (int v = 0; v < graph.Count(); v++)
+    {
+        if (v == root || parents[v] < 0)
+        {
+            continue;
+        }
+        int weight = EdgeWeightBetween(graph, parents[v], v);
+        if (weight < 0)
+        {
+            return false;
+        }
+        totalWeight += weight;
+
+        // Walk up until a vertex already known to reach the root; a tree path has at most V steps.
+        std::vector<int> path;
+        int current = v;
+        while (!reachesRoot[current])
+        {
+            if (parents[current] < 0 || (int)path.size() > graph.Count())
             {
-                gridSide = 30;
+                return false;
+            }
+            path.push_back(current);
+            current = parents[current];
+        }
+        for (int pathVertex : path)
+        {
+            reachesRoot[pathVertex] = 1;
+        }
+    }
+    return parents[root] == -1 && totalWeight == mstWeight;
+}
+
+// Renumbers large random and grid graphs with each ordering and times Dijkstra and Prim
+// (pairing heap, from original vertex 0) on the result. Speedups are relative to the original
+// numbering; reorder_us is the cost of computing the ordering and building the new graph.
+// matches_original also checks the predecessors and parents, mapped back to original ids.
+static void RunReorderBenchmark(int vertexCount)
+{
+    std::ofstream out("reorder_results.csv");
+    out << "graph_type,vertices,edges,ordering,reorder_us,dijkstra_us,prim_us,dijkstra_speedup,prim_speedup,matches_original\n";
+
+    int maxWeight = 20;
+    int gridSide = (int)std::sqrt((double)vertexCount);
+
+    std::vector<Graph> graphs = {
+        Graph::MakeRandomUndirectedGraph(vertexCount, 5 * vertexCount, maxWeight, 1000),
+        Graph::MakeRandomUndirectedGraph(vertexCount, 20 * vertexCount, maxWeight, 2000),
+        Graph::MakeGridUndirectedGraph(gridSide, gridSide, maxWeight, 3000)
+    };
+
+    const char* orderingNames[4] = {"original", "degree_sorted", "cuthill_mckee", "recursive_bisection"};
+
+    for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+    {
+        const Graph& g = graphs[graphIndex];
+        std::vector<int> originalDistances;
+        int originalMSTWeight = 0;
+        long long originalDijkstraUs = 0;
+        long long originalPrimUs = 0;
+
+        for (int orderingIndex = 0; orderingIndex < 4; orderingIndex++)
+        {
+            auto reorderStart = std::chrono::steady_clock::now();
+            VertexOrdering ordering;
+            if (orderingIndex == 0)
+            {
+                ordering = IdentityOrdering(g);
+            }
+            else if (orderingIndex == 1)
+            {
+                ordering = DegreeSortedOrdering(g);
+            }
+            else if (orderingIndex == 2)
+            {
+                ordering = CuthillMcKeeOrdering(g);
             }
             else
             {
-                gridSide = 70;
+                ordering = RecursiveBisectionOrdering(g);
             }
-            Graph gridGraph = Graph::MakeGridUndirectedGraph(gridSide, gridSide, maxWeight, 3000 + trial);
+            Graph reordered = (orderingIndex == 0) ? g : ApplyVertexOrdering(g, ordering);
+            auto reorderEnd = std::chrono::steady_clock::now();
+
+            int source = ordering.newIdForOldVertex[0];
+
+            auto dijkstraStart = std::chrono::steady_clock::now();
+            auto dijkstraResult = DijkstraUsingPairingHeap(reordered, source);
+            auto dijkstraEnd = std::chrono::steady_clock::now();
 
-            int k = n / 4;
-            Graph worstCase = Graph::MakeSyntheticWorstCaseGraph(n, k, maxWeight);
+            auto primStart = std::chrono::steady_clock::now();
+            auto primResult = PrimUsingPairingHeap(reordered, source);
+            auto primEnd = std::chrono::steady_clock::now();
 
-            Graph graphs[4] = {randomSparse, randomDense, gridGraph, worstCase};
-            std::string graphNames[4] = {"random_sparse", "random_dense", "grid", "synthetic_worst"};
+            long long reorderUs = (orderingIndex == 0) ? 0 : std::chrono::duration_cast<std::chrono::microseconds>(reorderEnd - reorderStart).count();
+            long long dijkstraUs = std::chrono::duration_cast<std::chrono::microseconds>(dijkstraEnd - dijkstraStart).count();
+            long long primUs = std::chrono::duration_cast<std::chrono::microseconds>(primEnd - primStart).count();
 
-            for (int graphIndex = 0; graphIndex < 4; graphIndex++)
+            std::vector<int> distances = MapValuesToOriginalIds(dijkstraResult.first, ordering);
+            std::vector<int> predecessors = MapVertexIdsToOriginalIds(dijkstraResult.second, ordering);
+            std::vector<int> parents = MapVertexIdsToOriginalIds(primResult.first, ordering);
+            if (orderingIndex == 0)
             {
-                Graph& g = graphs[graphIndex];
-                int V = g.Count();
-                int E = g.UndirectedEdgeCount();
+                originalDistances = distances;
+                originalMSTWeight = primResult.second;
+                originalDijkstraUs = dijkstraUs;
+                originalPrimUs = primUs;
+            }
+
+            bool matches = distances == originalDistances && primResult.second == originalMSTWeight &&
+                           IsShortestPathTree(g, 0, distances, predecessors) &&
+                           IsSpanningTreeOfWeight(g, 0, parents, originalMSTWeight);
+            WriteReorderRow(out, benchmarkGraphNames[graphIndex], g.Count(), g.UndirectedEdgeCount(), orderingNames[orderingIndex],
+                            reorderUs, dijkstraUs, primUs,
+                            (double)originalDijkstraUs / (double)std::max(1LL, dijkstraUs),
+                            (double)originalPrimUs / (double)std::max(1LL, primUs),
+                            matches);
+        }
+    }
+}
+
+// Compares plain and compressed adjacency on the 5000-vertex graphs: memory footprint,
+// encoding cost and Dijkstra/Prim time (pairing heap) on each representation.
+static void RunCompressedBenchmark()
+{
+    std::ofstream out("compressed_results.csv");
+    out << "graph_type,vertices,edges,plain_bytes,compressed_bytes,compression_ratio,encode_us,dijkstra_plain_us,dijkstra_compressed_us,prim_plain_us,prim_compressed_us,matches_plain\n";
+
+    std::vector<Graph> graphs = MakeBenchmarkGraphs(1, 0, 20);
+
+    for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+    {
+        const Graph& g = graphs[graphIndex];
+
+        auto encodeStart = std::chrono::steady_clock::now();
+        CompressedGraph compressed = CompressedGraph::FromGraph(g);
+        auto encodeEnd = std::chrono::steady_clock::now();
+
+        auto start1 = std::chrono::steady_clock::now();
+        auto plainDistances = DijkstraUsingPairingHeap(g, 0).first;
+        auto end1 = std::chrono::steady_clock::now();
+
+        auto start2 = std::chrono::steady_clock::now();
+        auto compressedDistances = DijkstraUsingPairingHeap(compressed, 0).first;
+        auto end2 = std::chrono::steady_clock::now();
+
+        auto start3 = std::chrono::steady_clock::now();
+        int plainMSTWeight = PrimUsingPairingHeap(g, 0).second;
+        auto end3 = std::chrono::steady_clock::now();
+
+        auto start4 = std::chrono::steady_clock::now();
+        int compressedMSTWeight = PrimUsingPairingHeap(compressed, 0).second;
+        auto end4 = std::chrono::steady_clock::now();
+
+        bool matches = plainDistances == compressedDistances && plainMSTWeight == compressedMSTWeight;
+
+        out << benchmarkGraphNames[graphIndex] << ","
+            << g.Count() << ","
+            << g.UndirectedEdgeCount() << ","
+            << g.AdjacencyBytes() << ","
+            << compressed.AdjacencyBytes() << ","
+            << (double)g.AdjacencyBytes() / (double)compressed.AdjacencyBytes() << ","
+            << std::chrono::duration_cast<std::chrono::microseconds>(encodeEnd - encodeStart).count() << ","
+            << std::chrono::duration_cast<std::chrono::microseconds>(end1 - start1).count() << ","
+            << std::chrono::duration_cast<std::chrono::microseconds>(end2 - start2).count() << ","
+            << std::chrono::duration_cast<std::chrono::microseconds>(end3 - start3).count() << ","
+            << std::chrono::duration_cast<std::chrono::microseconds>(end4 - start4).count() << ","
+            << (matches ? "yes" : "no") << "\n";
+    }
+}
+
+// Runs bounded Dijkstra queries (unbounded, radius, k-nearest, nearest of a target set) from
+// several sources on the 5000-vertex graphs, reusing one workspace per heap type, then radius
+// and k-nearest queries on grids of 10^4 to 10^6 vertices.
+static void RunQueryBenchmark()
+{
+    std::ofstream out("query_results.csv");
+    out << "graph_type,vertices,edges,query,parameter,heap,source,total_us,settled_count,insert_count,deletemin_count,decreasekey_count\n";
+
+    std::vector<Graph> graphs = MakeBenchmarkGraphs(1, 0, 20);
+    const char* queryNames[4] = {"full", "radius", "k_nearest", "nearest_target"};
+    const int sourceCount = 10;
+
+    for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+    {
+        const Graph& g = graphs[graphIndex];
+        DijkstraWorkspace<PairingHeapNode> pairingWorkspace;
+        DijkstraWorkspace<FibonacciHeapNode> fibonacciWorkspace;
+        std::mt19937 rng(4000 + graphIndex);
+        std::uniform_int_distribution<int> vertexDist(0, g.Count() - 1);
+
+        for (int sourceIndex = 0; sourceIndex < sourceCount; sourceIndex++)
+        {
+            int source = vertexDist(rng);
+
+            for (int queryIndex = 0; queryIndex < 4; queryIndex++)
+            {
+                DijkstraQuery query;
+                int parameter = 0;
+                if (queryIndex == 1)
+                {
+                    parameter = 10;
+                    query.distanceLimit = parameter;
+                }
+                else if (queryIndex == 2)
+                {
+                    parameter = 100;
+                    query.settledLimit = parameter;
+                }
+                else if (queryIndex == 3)
+                {
+                    parameter = 5;
+                    for (int targetIndex = 0; targetIndex < parameter; targetIndex++)
+                    {
+                        query.targets.push_back(vertexDist(rng));
+                    }
+                }
 
                 ResetPairingHeapStats();
                 auto start1 = std::chrono::steady_clock::now();
-                DijkstraUsingPairingHeap(g, 0);
+                DijkstraQueryResult r1 = DijkstraQueryUsingPairingHeap(g, source, query, pairingWorkspace);
                 auto end1 = std::chrono::steady_clock::now();
                 auto s1 = GetPairingHeapStats();
-                long long total1 = std::chrono::duration_cast<std::chrono::microseconds>(end1 - start1).count();
-                WriteRow(out, graphNames[graphIndex], V, E, "dijkstra", "pairing", trial, total1, s1.insertCount, s1.deleteMinCount, s1.decreaseKeyCount, s1.insertNs, s1.deleteMinNs, s1.decreaseKeyNs);
 
                 ResetFibonacciHeapStats();
                 auto start2 = std::chrono::steady_clock::now();
-                DijkstraUsingFibonacciHeap(g, 0);
+                DijkstraQueryResult r2 = DijkstraQueryUsingFibonacciHeap(g, source, query, fibonacciWorkspace);
                 auto end2 = std::chrono::steady_clock::now();
                 auto s2 = GetFibonacciHeapStats();
-                long long total2 = std::chrono::duration_cast<std::chrono::microseconds>(end2 - start2).count();
-                WriteRow(out, graphNames[graphIndex], V, E, "dijkstra", "fibonacci", trial, total2, s2.insertCount, s2.deleteMinCount, s2.decreaseKeyCount, s2.insertNs, s2.deleteMinNs, s2.decreaseKeyNs);
+
+                out << benchmarkGraphNames[graphIndex] << "," << g.Count() << "," << g.UndirectedEdgeCount() << ","
+                    << queryNames[queryIndex] << "," << parameter << ",pairing," << source << ","
+                    << std::chrono::duration_cast<std::chrono::microseconds>(end1 - start1).count() << ","
+                    << r1.settledVertices.size() << "," << s1.insertLatency.Count() << "," << s1.deleteMinLatency.Count() << "," << s1.decreaseKeyLatency.Count() << "\n";
+                out << benchmarkGraphNames[graphIndex] << "," << g.Count() << "," << g.UndirectedEdgeCount() << ","
+                    << queryNames[queryIndex] << "," << parameter << ",fibonacci," << source << ","
+                    << std::chrono::duration_cast<std::chrono::microseconds>(end2 - start2).count() << ","
+                    << r2.settledVertices.size() << "," << s2.insertLatency.Count() << "," << s2.deleteMinLatency.Count() << "," << s2.decreaseKeyLatency.Count() << "\n";
+            }
+        }
+    }
+
+    // Fixed-size queries on grids of growing size. The first query on each grid binds the
+    // workspace (O(V)) and is not written; the rest should take the same time at every size.
+    const int gridSides[3] = {100, 316, 1000};
+    for (int sideIndex = 0; sideIndex < 3; sideIndex++)
+    {
+        int side = gridSides[sideIndex];
+        Graph g = Graph::MakeGridUndirectedGraph(side, side, 100, 4100 + sideIndex);
+        DijkstraWorkspace<PairingHeapNode> pairingWorkspace;
+        std::mt19937 rng(4200 + sideIndex);
+        std::uniform_int_distribution<int> vertexDist(0, g.Count() - 1);
+
+        DijkstraQuery warmUp;
+        warmUp.settledLimit = 1;
+        DijkstraQueryUsingPairingHeap(g, 0, warmUp, pairingWorkspace);
+
+        for (int sourceIndex = 0; sourceIndex < sourceCount; sourceIndex++)
+        {
+            int source = vertexDist(rng);
+
+            for (int queryIndex = 1; queryIndex <= 2; queryIndex++)
+            {
+                DijkstraQuery query;
+                int parameter = queryIndex == 1 ? 200 : 100;
+                if (queryIndex == 1)
+                {
+                    query.distanceLimit = parameter;
+                }
+                else
+                {
+                    query.settledLimit = parameter;
+                }
 
                 ResetPairingHeapStats();
-                auto start3 = std::chrono::steady_clock::now();
-                PrimUsingPairingHeap(g, 0);
-                auto end3 = std::chrono::steady_clock::now();
-                auto s3 = GetPairingHeapStats();
-                long long total3 = std::chrono::duration_cast<std::chrono::microseconds>(end3 - start3).count();
-                WriteRow(out, graphNames[graphIndex], V, E, "prim", "pairing", trial, total3, s3.insertCount, s3.deleteMinCount, s3.decreaseKeyCount, s3.insertNs, s3.deleteMinNs, s3.decreaseKeyNs);
+                auto start = std::chrono::steady_clock::now();
+                DijkstraQueryResult r = DijkstraQueryUsingPairingHeap(g, source, query, pairingWorkspace);
+                auto end = std::chrono::steady_clock::now();
+                auto stats = GetPairingHeapStats();
 
-                ResetFibonacciHeapStats();
-                auto start4 = std::chrono::steady_clock::now();
-                PrimUsingFibonacciHeap(g, 0);
-                auto end4 = std::chrono::steady_clock::now();
-                auto s4 = GetFibonacciHeapStats();
-                long long total4 = std::chrono::duration_cast<std::chrono::microseconds>(end4 - start4).count();
-                WriteRow(out, graphNames[graphIndex], V, E, "prim", "fibonacci", trial, total4, s4.insertCount, s4.deleteMinCount, s4.decreaseKeyCount, s4.insertNs, s4.deleteMinNs, s4.decreaseKeyNs);
+                out << "grid_scaling," << g.Count() << "," << g.UndirectedEdgeCount() << ","
+                    << queryNames[queryIndex] << "," << parameter << ",pairing," << source << ","
+                    << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << ","
+                    << r.settledVertices.size() << "," << stats.insertLatency.Count() << "," << stats.deleteMinLatency.Count() << "," << stats.decreaseKeyLatency.Count() << "\n";
+            }
+        }
+    }
+}
+
+// updateCount random weight changes, deletions and insertions of undirected edges, each
+// expressed as one update per direction.
+static std::vector<EdgeUpdate> MakeRandomEdgeUpdates(const Graph& graph, int updateCount, int maxWeight, std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> vertexDist(0, graph.Count() - 1);
+    std::uniform_int_distribution<int> weightDist(1, maxWeight);
+    std::uniform_int_distribution<int> kindDist(0, 9);
+
+    std::vector<EdgeUpdate> updates;
+    Graph shadow = graph;
+
+    while ((int)updates.size() < 2 * updateCount)
+    {
+        int u = vertexDist(rng);
+        int kind = kindDist(rng);
+
+        if (kind == 0)
+        {
+            int v = vertexDist(rng);
+            if (u == v)
+            {
+                continue;
+            }
+            int w = weightDist(rng);
+            updates.push_back({EdgeUpdateKind::Insert, u, v, w});
+            updates.push_back({EdgeUpdateKind::Insert, v, u, w});
+            shadow.AddUndirectedEdge(u, v, w);
+            continue;
+        }
+
+        if (shadow.adj[u].empty())
+        {
+            continue;
+        }
+        std::uniform_int_distribution<int> edgeDist(0, (int)shadow.adj[u].size() - 1);
+        int v = shadow.adj[u][edgeDist(rng)].to;
+
+        if (kind == 1)
+        {
+            updates.push_back({EdgeUpdateKind::Delete, u, v, 0});
+            updates.push_back({EdgeUpdateKind::Delete, v, u, 0});
+            shadow.RemoveEdge(u, DynamicShortestPathTree::FindEdge(shadow.adj[u], v));
+            shadow.RemoveEdge(v, DynamicShortestPathTree::FindEdge(shadow.adj[v], u));
+        }
+        else
+        {
+            int w = weightDist(rng);
+            updates.push_back({EdgeUpdateKind::ChangeWeight, u, v, w});
+            updates.push_back({EdgeUpdateKind::ChangeWeight, v, u, w});
+            shadow.SetEdgeWeight(u, DynamicShortestPathTree::FindEdge(shadow.adj[u], v), w);
+            shadow.SetEdgeWeight(v, DynamicShortestPathTree::FindEdge(shadow.adj[v], u), w);
+        }
+    }
+
+    return updates;
+}
+
+// Applies batches of random edge updates to a DynamicShortestPathTree and compares the update
+// latency with a full DijkstraUsingPairingHeap recomputation on the updated graph.
+static void RunDynamicBenchmark()
+{
+    std::ofstream out("dynamic_results.csv");
+    out << "graph_type,vertices,edges,batch_size,update_us,recompute_us,speedup,touched_vertices,matches_recompute\n";
+
+    std::vector<Graph> graphs = MakeBenchmarkGraphs(1, 0, 20);
+    const int batchSizes[4] = {1, 10, 100, 1000};
+
+    for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+    {
+        DynamicShortestPathTree tree(graphs[graphIndex], 0);
+        std::mt19937 rng(5000 + graphIndex);
+
+        for (int batchIndex = 0; batchIndex < 4; batchIndex++)
+        {
+            std::vector<EdgeUpdate> updates = MakeRandomEdgeUpdates(tree.CurrentGraph(), batchSizes[batchIndex], 20, rng);
+            long long touchedBefore = tree.TouchedVertexCount();
+
+            auto start1 = std::chrono::steady_clock::now();
+            tree.ApplyBatch(updates);
+            auto end1 = std::chrono::steady_clock::now();
+
+            auto start2 = std::chrono::steady_clock::now();
+            std::vector<int> recomputed = DijkstraUsingPairingHeap(tree.CurrentGraph(), 0).first;
+            auto end2 = std::chrono::steady_clock::now();
+
+            long long updateUs = std::chrono::duration_cast<std::chrono::microseconds>(end1 - start1).count();
+            long long recomputeUs = std::chrono::duration_cast<std::chrono::microseconds>(end2 - start2).count();
+
+            out << benchmarkGraphNames[graphIndex] << ","
+                << tree.CurrentGraph().Count() << ","
+                << tree.CurrentGraph().UndirectedEdgeCount() << ","
+                << batchSizes[batchIndex] << ","
+                << updateUs << ","
+                << recomputeUs << ","
+                << (double)recomputeUs / (double)std::max(1LL, updateUs) << ","
+                << tree.TouchedVertexCount() - touchedBefore << ","
+                << (recomputed == tree.Distances() ? "yes" : "no") << "\n";
+        }
+    }
+}
+
+// Weight of the minimum spanning forest: PrimUsingPairingHeap from vertex 0 and then from every
+// vertex no earlier run reached.
+static long long PrimSpanningForestWeight(const Graph& graph)
+{
+    std::vector<bool> reached(graph.Count(), false);
+    long long totalWeight = 0;
+
+    for (int startVertex = 0; startVertex < graph.Count(); startVertex++)
+    {
+        if (reached[startVertex])
+        {
+            continue;
+        }
+
+        std::pair<std::vector<int>, int> mst = PrimUsingPairingHeap(graph, startVertex);
+        totalWeight += mst.second;
+        reached[startVertex] = true;
+        for (int v = 0; v < graph.Count(); v++)
+        {
+            if (mst.first[v] != -1)
+            {
+                reached[v] = true;
+            }
+        }
+    }
+
+    return totalWeight;
+}
+
+// Applies batches of random edge insertions and weight decreases to a
+// DynamicMinimumSpanningTree and compares the update latency with a full PrimUsingPairingHeap
+// recomputation on the updated graph. The forest weight must equal the Prim forest weight.
+static void RunDynamicMstBenchmark()
+{
+    std::ofstream out("dynamic_mst_results.csv");
+    out << "graph_type,vertices,edges,batch_size,update_us,recompute_us,speedup,updates_per_sec,forest_replacements,matches_recompute\n";
+
+    std::vector<Graph> graphs = MakeBenchmarkGraphs(1, 0, 1000);
+    const int batchSizes[4] = {1, 10, 100, 1000};
+
+    for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+    {
+        Graph current = graphs[graphIndex];
+        DynamicMinimumSpanningTree tree = DynamicMinimumSpanningTree::FromGraph(current);
+        std::mt19937 rng(6000 + graphIndex);
+        std::uniform_int_distribution<int> vertexDist(0, current.Count() - 1);
+        std::uniform_int_distribution<int> kindDist(0, 1);
+
+        // Endpoints of every edge id, so weight decreases can be mirrored into current.
+        std::vector<std::pair<int, int>> endpoints;
+        for (int u = 0; u < current.Count(); u++)
+        {
+            for (int edgeIndex = 0; edgeIndex < (int)current.adj[u].size(); edgeIndex++)
+            {
+                if (current.adj[u][edgeIndex].to > u)
+                {
+                    endpoints.push_back({u, current.adj[u][edgeIndex].to});
+                }
+            }
+        }
+
+        for (int batchIndex = 0; batchIndex < 4; batchIndex++)
+        {
+            int replacements = 0;
+            long long updateNs = 0;
+
+            for (int updateIndex = 0; updateIndex < batchSizes[batchIndex]; updateIndex++)
+            {
+                int u;
+                int v;
+                int weight;
+                int edgeId = -1;
+
+                if (kindDist(rng) == 0)
+                {
+                    u = vertexDist(rng);
+                    v = vertexDist(rng);
+                    if (u == v)
+                    {
+                        updateIndex--;
+                        continue;
+                    }
+                    weight = std::uniform_int_distribution<int>(1, 1000)(rng);
+                    current.AddUndirectedEdge(u, v, weight);
+                    endpoints.push_back({u, v});
+                }
+                else
+                {
+                    edgeId = std::uniform_int_distribution<int>(0, tree.EdgeCount() - 1)(rng);
+                    u = endpoints[edgeId].first;
+                    v = endpoints[edgeId].second;
+                    weight = std::uniform_int_distribution<int>(1, tree.EdgeWeight(edgeId))(rng);
+
+                    // Parallel copies are only told apart by weight. That is enough here, since
+                    // the MST weight depends only on the multiset of u-v weights.
+                    int oldWeight = tree.EdgeWeight(edgeId);
+                    for (int side = 0; side < 2; side++)
+                    {
+                        int from = side == 0 ? u : v;
+                        int to = side == 0 ? v : u;
+                        for (int edgeIndex = 0; edgeIndex < (int)current.adj[from].size(); edgeIndex++)
+                        {
+                            const Edge& edge = current.adj[from][edgeIndex];
+                            if (edge.to == to && edge.weight == oldWeight)
+                            {
+                                current.SetEdgeWeight(from, edgeIndex, weight);
+                                break;
+                            }
+                        }
+                    }
+                }
+
+                bool wasInForest = edgeId >= 0 && tree.EdgeInForest(edgeId);
+                int forestEdgesBefore = tree.ForestEdgeCount();
+
+                auto start1 = std::chrono::steady_clock::now();
+                if (edgeId < 0)
+                {
+                    edgeId = tree.InsertEdge(u, v, weight);
+                }
+                else
+                {
+                    tree.DecreaseEdgeWeight(edgeId, weight);
+                }
+                auto end1 = std::chrono::steady_clock::now();
+                updateNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end1 - start1).count();
+
+                if (!wasInForest && tree.EdgeInForest(edgeId) && tree.ForestEdgeCount() == forestEdgesBefore)
+                {
+                    replacements++;
+                }
+            }
+
+            auto start2 = std::chrono::steady_clock::now();
+            long long recomputedWeight = PrimSpanningForestWeight(current);
+            auto end2 = std::chrono::steady_clock::now();
+
+            long long updateUs = updateNs / 1000;
+            long long recomputeUs = std::chrono::duration_cast<std::chrono::microseconds>(end2 - start2).count();
+
+            out << benchmarkGraphNames[graphIndex] << ","
+                << current.Count() << ","
+                << current.UndirectedEdgeCount() << ","
+                << batchSizes[batchIndex] << ","
+                << updateUs << ","
+                << recomputeUs << ","
+                << (double)recomputeUs / (double)std::max(1LL, updateUs) << ","
+                << (double)batchSizes[batchIndex] * 1e9 / (double)std::max(1LL, updateNs) << ","
+                << replacements << ","
+                << (recomputedWeight == tree.TotalWeight() ? "yes" : "no") << "\n";
+        }
+    }
+}
+
+// Runs Dijkstra and Prim (pairing heap) on a large grid stored as a CsrGraph under each
+// allocation policy. The graph arrays and the heap node pools both come from the policy, so
+// the difference between rows is the cost of TLB reach; dtlb_misses is -1 when the kernel does
+// not expose the counter. Policies the machine cannot honor fall back and say so in the
+// fallback columns. The active --alloc policy is restored afterwards.
+static void RunAllocationBenchmark(int vertexCount)
+{
+    std::ofstream out("alloc_results.csv");
+    out << "policy,algorithm,vertices,edges,build_us,total_us,dtlb_misses,regions_mapped,anon_huge_bytes,hugetlb_fallbacks,advise_failures,numa_failures,matches_default\n";
+
+    int side = std::max(2, (int)std::sqrt((double)vertexCount));
+    Graph grid = Graph::MakeGridUndirectedGraph(side, side, 100, 7);
+
+    AllocationPolicy previousPolicy = activeAllocationPolicy;
+    const char* policyNames[4] = {"default", "thp", "hugetlb", "thp:interleave"};
+
+    std::vector<int> defaultDistances;
+    int defaultMstWeight = 0;
+
+    for (int policyIndex = 0; policyIndex < 4; policyIndex++)
+    {
+        AllocationPolicy policy;
+        ParseAllocationPolicy(policyNames[policyIndex], policy);
+        SetAllocationPolicy(policy);
+        ResetAllocationStats();
+
+        auto buildStart = std::chrono::steady_clock::now();
+        CsrGraph csr = CsrGraph::FromGraph(grid);
+        auto buildEnd = std::chrono::steady_clock::now();
+        long long buildUs = std::chrono::duration_cast<std::chrono::microseconds>(buildEnd - buildStart).count();
+
+        for (int algorithmIndex = 0; algorithmIndex < 2; algorithmIndex++)
+        {
+            TlbMissCounter tlbMisses;
+            bool matches;
+
+            tlbMisses.Start();
+            auto start = std::chrono::steady_clock::now();
+            if (algorithmIndex == 0)
+            {
+                std::vector<int> distances = DijkstraUsingPairingHeap(csr, 0).first;
+                if (policyIndex == 0)
+                {
+                    defaultDistances = distances;
+                }
+                matches = distances == defaultDistances;
             }
+            else
+            {
+                int mstWeight = PrimUsingPairingHeap(csr, 0).second;
+                if (policyIndex == 0)
+                {
+                    defaultMstWeight = mstWeight;
+                }
+                matches = mstWeight == defaultMstWeight;
+            }
+            auto end = std::chrono::steady_clock::now();
+            long long misses = tlbMisses.Stop();
+
+            AllocationStats stats = GetAllocationStats();
+            out << AllocationPolicyName(policy) << ","
+                << (algorithmIndex == 0 ? "dijkstra" : "prim") << ","
+                << csr.Count() << ","
+                << grid.UndirectedEdgeCount() << ","
+                << buildUs << ","
+                << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << ","
+                << misses << ","
+                << stats.regionsMapped << ","
+                << AnonHugePageBytes() << ","
+                << stats.hugeTlbFallbacks << ","
+                << stats.adviseFailures << ","
+                << stats.numaFailures << ","
+                << (matches ? "yes" : "no") << "\n";
         }
     }
 
+    SetAllocationPolicy(previousPolicy);
+}
+
+// Runs ParallelPrim with both heaps and 1, 2, 4 and 8 threads on the 5000-vertex graphs and
+// on a dense 20000-vertex random graph (100 edges per vertex), next to sequential Prim with
+// the same heap. The tree weight must match the sequential one.
+static void RunParallelMstBenchmark()
+{
+    std::ofstream out("parallel_mst_results.csv");
+    out << "graph_type,vertices,edges,heap,threads,total_us,sequential_us,speedup,trees,boruvka_rounds,melds,matches_sequential\n";
+
+    std::vector<Graph> graphs = MakeBenchmarkGraphs(1, 0, 1000);
+    graphs.push_back(Graph::MakeRandomUndirectedGraph(20000, 2000000, 1000, 7000));
+    const char* graphNames[5] = {"random_sparse", "random_dense", "grid", "synthetic_worst", "random_dense_large"};
+    const int threadCounts[4] = {1, 2, 4, 8};
+
+    for (int graphIndex = 0; graphIndex < (int)graphs.size(); graphIndex++)
+    {
+        const Graph& g = graphs[graphIndex];
+
+        for (int heapIndex = 0; heapIndex < 2; heapIndex++)
+        {
+            auto start1 = std::chrono::steady_clock::now();
+            int sequentialWeight = (heapIndex == 0) ? PrimUsingPairingHeap(g, 0).second : PrimUsingFibonacciHeap(g, 0).second;
+            auto end1 = std::chrono::steady_clock::now();
+            long long sequentialUs = std::chrono::duration_cast<std::chrono::microseconds>(end1 - start1).count();
+
+            for (int threadIndex = 0; threadIndex < 4; threadIndex++)
+            {
+                int threads = threadCounts[threadIndex];
+
+                auto start2 = std::chrono::steady_clock::now();
+                int parallelWeight = (heapIndex == 0) ? ParallelPrimUsingPairingHeap(g, 0, threads).second
+                                                      : ParallelPrimUsingFibonacciHeap(g, 0, threads).second;
+                auto end2 = std::chrono::steady_clock::now();
+                long long parallelUs = std::chrono::duration_cast<std::chrono::microseconds>(end2 - start2).count();
+                ParallelPrimStats stats = GetParallelPrimStats();
+
+                out << graphNames[graphIndex] << ","
+                    << g.Count() << ","
+                    << g.UndirectedEdgeCount() << ","
+                    << (heapIndex == 0 ? "pairing" : "fibonacci") << ","
+                    << threads << ","
+                    << parallelUs << ","
+                    << sequentialUs << ","
+                    << (double)sequentialUs / (double)std::max(1LL, parallelUs) << ","
+                    << stats.treeCount << ","
+                    << stats.boruvkaRounds << ","
+                    << stats.meldCount << ","
+                    << (parallelWeight == sequentialWeight ? "yes" : "no") << "\n";
+            }
+        }
+    }
+}
+
+static void ReportQueryServerStats(const QueryServerStats& stats)
+{
+    std::cerr << "served " << stats.queryCount << " queries in " << stats.elapsedSeconds << " s: "
+              << stats.queriesPerSecond << " queries/sec, p50 " << stats.p50LatencyUs
+              << " us, p99 " << stats.p99LatencyUs << " us\n";
+    if (stats.outputClosed)
+    {
+        std::cerr << "client stopped reading answers; the rest of its queries were dropped\n";
+    }
+
+    const char* operationNames[3] = {"insert", "deletemin", "decreasekey"};
+    const LatencyHistogram* operationLatencies[3] = {
+        &stats.heapStats.insertLatency, &stats.heapStats.deleteMinLatency, &stats.heapStats.decreaseKeyLatency};
+    for (int operationIndex = 0; operationIndex < 3; operationIndex++)
+    {
+        const LatencyHistogram& latency = *operationLatencies[operationIndex];
+        std::cerr << "  " << operationNames[operationIndex] << ": " << latency.Count() << " ops, p50 "
+                  << latency.PercentileNs(50.0) << " ns, p99 " << latency.PercentileNs(99.0) << " ns, p999 "
+                  << latency.PercentileNs(99.9) << " ns, max " << latency.MaxNs() << " ns\n";
+    }
+}
+
+// Loads (or generates) the graph once and answers queries from stdin, or from clients of a
+// Unix socket when socketPath is set. Statistics go to stderr so they stay out of the answers.
+static int RunQueryServer(const std::string& csrPath, int vertexCount, const std::string& socketPath,
+                          const QueryServerOptions& options)
+{
+    auto loadStart = std::chrono::steady_clock::now();
+    Graph graph(0);
+    try
+    {
+        if (!csrPath.empty())
+        {
+            graph = ReadGraphFromCsrFile(csrPath);
+        }
+        else
+        {
+            int side = std::max(1, (int)std::sqrt((double)vertexCount));
+            graph = Graph::MakeGridUndirectedGraph(side, side, 100, 42);
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    auto loadEnd = std::chrono::steady_clock::now();
+
+    std::cerr << "loaded graph with " << graph.Count() << " vertices and " << graph.UndirectedEdgeCount()
+              << " edges in " << std::chrono::duration<double>(loadEnd - loadStart).count() << " s, "
+              << options.workerCount << " workers\n";
+
+    QueryServer server(graph, options);
+
+    if (socketPath.empty())
+    {
+        QueryServerStats stats = server.RunSession(
+            [](std::string& line) { return (bool)std::getline(std::cin, line); },
+            [](const std::string& answer) { return (bool)(std::cout << answer << "\n" << std::flush); });
+        ReportQueryServerStats(stats);
+        return 0;
+    }
+
+#ifdef QUERY_SERVER_HAS_UNIX_SOCKETS
+    try
+    {
+        ServeQueriesOnUnixSocket(server, socketPath, ReportQueryServerStats);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    return 0;
+#else
+    std::cerr << "Unix sockets are not available on this platform\n";
+    return 1;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    bool runExternalBenchmark = false;
+    bool runReorderBenchmark = false;
+    bool runCompressedBenchmark = false;
+    bool runQueryBenchmark = false;
+    bool runDynamicBenchmark = false;
+    bool runDynamicMstBenchmark = false;
+    bool runAllocationBenchmark = false;
+    bool runParallelMstBenchmark = false;
+    bool calibrateAutoHeap = false;
+    int allocationVertexCount = 1000000;
+    int reorderVertexCount = 200000;
+    std::string externalCsrPath;
+    int queueMemoryEntries = 4096;
+    bool runQueryServer = false;
+    std::string serveSocketPath;
+    std::string serveCsrPath;
+    int serveVertexCount = 1000000;
+    QueryServerOptions serverOptions = {std::max(1, (int)std::thread::hardware_concurrency()), 16};
+
+    for (int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        const char* arg = argv[argIndex];
+
+        if (std::strncmp(arg, "--relaxation=", 13) == 0)
+        {
+            RelaxationKernelKind kind;
+            if (!ParseRelaxationKernelKind(arg + 13, kind))
+            {
+                std::cerr << "Unknown relaxation kernel: " << (arg + 13) << "\n";
+                return 1;
+            }
+            SetRelaxationKernel(kind);
+        }
+        else if (std::strncmp(arg, "--alloc=", 8) == 0)
+        {
+            AllocationPolicy policy;
+            if (!ParseAllocationPolicy(arg + 8, policy))
+            {
+                std::cerr << "Unknown allocation policy: " << (arg + 8) << "\n";
+                return 1;
+            }
+            SetAllocationPolicy(policy);
+        }
+        else if (std::strcmp(arg, "--alloc-benchmark") == 0)
+        {
+            runAllocationBenchmark = true;
+        }
+        else if (std::strncmp(arg, "--alloc-vertices=", 17) == 0)
+        {
+            runAllocationBenchmark = true;
+            allocationVertexCount = std::atoi(arg + 17);
+        }
+        else if (std::strcmp(arg, "--external") == 0)
+        {
+            runExternalBenchmark = true;
+        }
+        else if (std::strncmp(arg, "--external-csr=", 15) == 0)
+        {
+            externalCsrPath = arg + 15;
+        }
+        else if (std::strcmp(arg, "--serve") == 0)
+        {
+            runQueryServer = true;
+        }
+        else if (std::strncmp(arg, "--serve-socket=", 15) == 0)
+        {
+            runQueryServer = true;
+            serveSocketPath = arg + 15;
+        }
+        else if (std::strncmp(arg, "--serve-csr=", 12) == 0)
+        {
+            serveCsrPath = arg + 12;
+        }
+        else if (std::strncmp(arg, "--serve-vertices=", 17) == 0)
+        {
+            serveVertexCount = std::atoi(arg + 17);
+        }
+        else if (std::strncmp(arg, "--workers=", 10) == 0)
+        {
+            serverOptions.workerCount = std::max(1, std::atoi(arg + 10));
+        }
+        else if (std::strncmp(arg, "--batch=", 8) == 0)
+        {
+            serverOptions.batchSize = std::max(1, std::atoi(arg + 8));
+        }
+        else if (std::strcmp(arg, "--batch-decrease-key") == 0)
+        {
+            stageRelaxedDecreaseKeys = true;
+        }
+        else if (std::strcmp(arg, "--auto-calibrate") == 0)
+        {
+            calibrateAutoHeap = true;
+        }
+        else if (std::strcmp(arg, "--parallel-mst") == 0)
+        {
+            runParallelMstBenchmark = true;
+        }
+        else if (std::strcmp(arg, "--dynamic-mst") == 0)
+        {
+            runDynamicMstBenchmark = true;
+        }
+        else if (std::strcmp(arg, "--dynamic") == 0)
+        {
+            runDynamicBenchmark = true;
+        }
+        else if (std::strcmp(arg, "--queries") == 0)
+        {
+            runQueryBenchmark = true;
+        }
+        else if (std::strcmp(arg, "--compressed") == 0)
+        {
+            runCompressedBenchmark = true;
+        }
+        else if (std::strcmp(arg, "--reorder") == 0)
+        {
+            runReorderBenchmark = true;
+        }
+        else if (std::strncmp(arg, "--reorder-vertices=", 19) == 0)
+        {
+            runReorderBenchmark = true;
+            reorderVertexCount = std::atoi(arg + 19);
+        }
+        else if (std::strncmp(arg, "--queue-memory=", 15) == 0)
+        {
+            queueMemoryEntries = std::atoi(arg + 15);
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    // Serving stdin reads and writes a line per query; the standard streams must be untied from
+    // stdio before any I/O on them, including the log lines below.
+    if (runQueryServer && serveSocketPath.empty())
+    {
+        std::ios::sync_with_stdio(false);
+    }
+
+    std::cerr << "relaxation kernel: " << RelaxationKernelName(activeRelaxationKernelKind) << "\n";
+    std::cerr << "allocation policy: " << AllocationPolicyName(activeAllocationPolicy) << "\n";
+    std::cerr << "prefetch: " << (PQ_PREFETCH_ENABLED ? "on" : "off") << "\n";
+    std::cerr << "decrease-key: " << (stageRelaxedDecreaseKeys ? "batched" : "single") << "\n";
+
+    if (runQueryServer)
+    {
+        return RunQueryServer(serveCsrPath, serveVertexCount, serveSocketPath, serverOptions);
+    }
+
+    if (!externalCsrPath.empty())
+    {
+        try
+        {
+            RunExternalOnCsrFile(externalCsrPath, queueMemoryEntries);
+        }
+        catch (const std::exception& error)
+        {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // Each mode flag runs only its own benchmark; the full heap matrix (results.csv) runs when
+    // no mode is given.
+    bool modeSelected = runExternalBenchmark || runDynamicBenchmark || runDynamicMstBenchmark ||
+                        runParallelMstBenchmark || runQueryBenchmark || runCompressedBenchmark ||
+                        runReorderBenchmark || runAllocationBenchmark;
+    if (!modeSelected)
+    {
+        RunHeapBenchmark(calibrateAutoHeap);
+    }
+
+    if (runExternalBenchmark)
+    {
+        RunExternalBenchmark(queueMemoryEntries);
+    }
+
+    if (runDynamicBenchmark)
+    {
+        RunDynamicBenchmark();
+    }
+
+    if (runDynamicMstBenchmark)
+    {
+        RunDynamicMstBenchmark();
+    }
+
+    if (runParallelMstBenchmark)
+    {
+        RunParallelMstBenchmark();
+    }
+
+    if (runQueryBenchmark)
+    {
+        RunQueryBenchmark();
+    }
+
+    if (runCompressedBenchmark)
+    {
+        RunCompressedBenchmark();
+    }
+
+    if (runReorderBenchmark)
+    {
+        RunReorderBenchmark(reorderVertexCount);
+    }
+
+    if (runAllocationBenchmark)
+    {
+        RunAllocationBenchmark(allocationVertexCount);
+    }
+
     return 0;
 }